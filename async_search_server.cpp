@@ -0,0 +1,93 @@
+#include "async_search_server.h"
+
+#include <exception>
+
+AsyncSearchServer::AsyncSearchServer(const SearchServer& search_server, size_t max_pending_query_count, size_t thread_count)
+    : search_server_(search_server)
+    , max_pending_query_count_(std::max<size_t>(max_pending_query_count, 1))
+    , pool_(thread_count)
+{
+}
+
+AsyncSearchServer::QueryFuture AsyncSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, Deadline deadline) {
+    return *Submit(raw_query, status, deadline, true);
+}
+
+std::optional<AsyncSearchServer::QueryFuture> AsyncSearchServer::TryFindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    Deadline deadline) {
+    return Submit(raw_query, status, deadline, false);
+}
+
+size_t AsyncSearchServer::GetPendingQueryCount() const {
+    std::lock_guard lock(mutex_);
+    return pending_query_count_;
+}
+
+std::optional<AsyncSearchServer::QueryFuture> AsyncSearchServer::Submit(std::string_view raw_query, DocumentStatus status,
+    Deadline deadline, bool wait_for_space) {
+    std::string key = std::to_string(static_cast<int>(status)) + ' ';
+    key += raw_query;
+
+    // Поиск с более поздним сроком подходит и для этого запроса.
+    const auto find_pending = [&]() -> std::optional<QueryFuture> {
+        const auto it = pending_queries_.find(key);
+        if (it != pending_queries_.end() && it->second.deadline >= deadline) {
+            return it->second.future;
+        }
+        return std::nullopt;
+    };
+
+    {
+        std::lock_guard lock(mutex_);
+        if (auto future = find_pending()) {
+            return future;
+        }
+    }
+
+    // Разбор вне блокировки; ошибки запроса бросаются вызывающему.
+    auto query = std::make_shared<SearchServer::PreparedQuery>(search_server_.PrepareSearchQuery(raw_query));
+    auto promise = std::make_shared<std::promise<std::vector<Document>>>();
+
+    std::unique_lock lock(mutex_);
+    while (pending_query_count_ >= max_pending_query_count_) {
+        if (!wait_for_space) {
+            return std::nullopt;
+        }
+        query_finished_.wait(lock);
+    }
+    // Пока разбирали запрос или ждали места, такой же мог быть поставлен.
+    if (auto future = find_pending()) {
+        return future;
+    }
+
+    QueryFuture future = promise->get_future().share();
+    pending_queries_[key] = PendingQuery{ promise.get(), future, deadline };
+    ++pending_query_count_;
+    lock.unlock();
+
+    pool_.Submit([this, key = std::move(key), query, status, deadline, promise] {
+        RunQuery(key, *query, status, deadline, *promise);
+        });
+    return future;
+}
+
+void AsyncSearchServer::RunQuery(const std::string& key, const SearchServer::PreparedQuery& query, DocumentStatus status,
+    Deadline deadline, std::promise<std::vector<Document>>& promise) {
+    try {
+        promise.set_value(search_server_.FindTopDocuments(std::execution::seq, query, status,
+            SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT, deadline));
+    }
+    catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        const auto it = pending_queries_.find(key);
+        if (it != pending_queries_.end() && it->second.promise == &promise) {
+            pending_queries_.erase(it);
+        }
+        --pending_query_count_;
+    }
+    query_finished_.notify_all();
+}
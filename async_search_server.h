@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "search_server.h"
+#include "work_stealing_pool.h"
+
+/**
+	* Асинхронный интерфейс поиска: запрос ставится в очередь пула потоков, а
+	* вызывающий получает future с выдачей и не занимает поток на время поиска.
+	*
+	* Одинаковые запросы (тот же текст и статус), поставленные, пока первый ещё не
+	* выполнен, не считаются повторно и получают его future. Число выполняемых и
+	* ждущих запросов ограничено: FindTopDocuments ждёт места в очереди,
+	* TryFindTopDocuments сразу отказывает. Запрос со сроком прерывается, как только
+	* срок наступил, и его future бросает DeadlineExceeded.
+	*
+	* Сервер не должен меняться, пока запросы не выполнены. Деструктор дожидается
+	* выполнения всех поставленных запросов.
+	**/
+class AsyncSearchServer {
+public:
+    using Deadline = SearchServer::Deadline;
+    using QueryFuture = std::shared_future<std::vector<Document>>;
+
+    AsyncSearchServer(const SearchServer& search_server, size_t max_pending_query_count,
+        size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+
+    AsyncSearchServer(const AsyncSearchServer&) = delete;
+    AsyncSearchServer& operator=(const AsyncSearchServer&) = delete;
+
+    // Ждёт, пока в очереди освободится место. Ошибки разбора запроса бросаются сразу.
+    QueryFuture FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        Deadline deadline = SearchServer::NO_DEADLINE);
+
+    // Возвращает nullopt, если очередь заполнена.
+    std::optional<QueryFuture> TryFindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        Deadline deadline = SearchServer::NO_DEADLINE);
+
+    // Число запросов в очереди и в работе; объединённые запросы считаются за один.
+    size_t GetPendingQueryCount() const;
+
+private:
+    // Поставленный поиск: к нему присоединяются одинаковые запросы с тем же или
+    // более ранним сроком.
+    struct PendingQuery {
+        const std::promise<std::vector<Document>>* promise;    // отличает поиск от следующего с тем же ключом
+        QueryFuture future;
+        Deadline deadline;
+    };
+
+    const SearchServer& search_server_;
+    const size_t max_pending_query_count_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable query_finished_;
+    std::unordered_map<std::string, PendingQuery> pending_queries_;    // ключ - статус и текст запроса
+    size_t pending_query_count_ = 0;
+
+    // Объявлен последним: его деструктор выполняет оставшиеся задачи, которым нужны
+    // остальные поля.
+    WorkStealingPool pool_;
+
+    std::optional<QueryFuture> Submit(std::string_view raw_query, DocumentStatus status, Deadline deadline, bool wait_for_space);
+
+    void RunQuery(const std::string& key, const SearchServer::PreparedQuery& query, DocumentStatus status, Deadline deadline,
+        std::promise<std::vector<Document>>& promise);
+};
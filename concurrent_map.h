@@ -54,13 +54,10 @@ public:
         return result;
     }
 
-    void erase(int document_id) {
-        for (auto& [mutex, map] : buckets_) {
-            if (map.count(document_id)) {
-                std::lock_guard g(mutex);
-                map.erase(document_id);
-            }
-        }
+    void erase(const Key& key) {
+        auto& bucket = buckets_[static_cast<uint64_t>(key) % buckets_.size()];
+        std::lock_guard g(bucket.mutex);
+        bucket.map.erase(key);
     }
 
 private:
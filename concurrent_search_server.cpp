@@ -0,0 +1,459 @@
+#include "concurrent_search_server.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std::string_literals;
+
+ConcurrentSearchServer::ConcurrentSearchServer(const std::string& stop_words_text, size_t segment_size)
+    : ConcurrentSearchServer(SplitIntoWords(stop_words_text), segment_size)
+{
+}
+
+ConcurrentSearchServer::ConcurrentSearchServer(std::string_view stop_words_text, size_t segment_size)
+    : ConcurrentSearchServer(SplitIntoWordsView(stop_words_text), segment_size)
+{
+}
+
+ConcurrentSearchServer::~ConcurrentSearchServer() {
+    {
+        std::lock_guard lock(write_mutex_);
+        stopping_ = true;
+    }
+    merge_condition_.notify_all();
+    merge_thread_.join();
+}
+
+void ConcurrentSearchServer::Start() {
+    // Некорректные стоп-слова бросают invalid_argument до запуска фонового потока.
+    active_[0] = std::make_unique<SearchServer>(stop_words_);
+    active_[1] = std::make_unique<SearchServer>(stop_words_);
+
+    auto generation = std::make_unique<Generation>();
+    generation->active = active_[0].get();
+    current_.store(generation.get(), std::memory_order_seq_cst);
+    published_ = std::move(generation);
+
+    merge_thread_ = std::thread([this] {
+        MergeLoop();
+        });
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    CheckNotReading();
+    std::lock_guard update_lock(update_mutex_);
+    std::unique_lock lock(write_mutex_);
+    CheckNotSealed(document_id);
+    WriteActive(lock, [&](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings);
+        });
+}
+
+void ConcurrentSearchServer::AddDocuments(const std::vector<SearchServer::DocumentInput>& documents) {
+    AddDocuments(std::execution::seq, documents);
+}
+
+void ConcurrentSearchServer::AddDocuments(std::execution::sequenced_policy seq, const std::vector<SearchServer::DocumentInput>& documents) {
+    CheckNotReading();
+    std::lock_guard update_lock(update_mutex_);
+    std::unique_lock lock(write_mutex_);
+    for (const auto& document : documents) {
+        CheckNotSealed(document.id);
+    }
+    WriteActive(lock, [&](SearchServer& server) {
+        server.AddDocuments(seq, documents);
+        });
+}
+
+void ConcurrentSearchServer::AddDocuments(std::execution::parallel_policy par, const std::vector<SearchServer::DocumentInput>& documents) {
+    CheckNotReading();
+    std::lock_guard update_lock(update_mutex_);
+    std::unique_lock lock(write_mutex_);
+    for (const auto& document : documents) {
+        CheckNotSealed(document.id);
+    }
+    WriteActive(lock, [&](SearchServer& server) {
+        server.AddDocuments(par, documents);
+        });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void ConcurrentSearchServer::RemoveDocument(std::execution::sequenced_policy seq, int document_id) {
+    RemoveDocumentBatch(seq, { document_id });
+}
+
+void ConcurrentSearchServer::RemoveDocument(std::execution::parallel_policy par, int document_id) {
+    RemoveDocumentBatch(par, { document_id });
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+void ConcurrentSearchServer::RemoveDocuments(std::execution::sequenced_policy seq, const std::vector<int>& document_ids) {
+    RemoveDocumentBatch(seq, document_ids);
+}
+
+void ConcurrentSearchServer::RemoveDocuments(std::execution::parallel_policy par, const std::vector<int>& document_ids) {
+    RemoveDocumentBatch(par, document_ids);
+}
+
+template <typename ExecutionPolicy>
+void ConcurrentSearchServer::RemoveDocumentBatch(ExecutionPolicy policy, const std::vector<int>& document_ids) {
+    CheckNotReading();
+    std::lock_guard update_lock(update_mutex_);
+    std::unique_lock lock(write_mutex_);
+    std::vector<int> active_ids;
+    std::vector<std::vector<int>> sealed_ids;
+    SplitBySegment(document_ids, active_ids, sealed_ids);
+
+    // Запечатанные сегменты не меняются: документы отмечаются в новых списках удалённых.
+    auto generation = CopyGeneration();
+    bool sealed_changed = false;
+    for (size_t i = 0; i < sealed_ids.size(); ++i) {
+        if (sealed_ids[i].empty()) {
+            continue;
+        }
+        SealedSegment& segment = generation->sealed[i];
+        auto changes = std::make_shared<SegmentChanges>();
+        std::merge(segment.changes->removed_ids.begin(), segment.changes->removed_ids.end(),
+            sealed_ids[i].begin(), sealed_ids[i].end(), std::back_inserter(changes->removed_ids));
+        changes->statuses = segment.changes->statuses;
+        segment.changes = std::move(changes);
+        sealed_changed = true;
+    }
+
+    if (!active_ids.empty()) {
+        WriteActive(lock, [&](SearchServer& server) {
+            server.RemoveDocuments(policy, active_ids);
+            }, sealed_changed ? std::move(generation) : nullptr);
+    } else if (sealed_changed) {
+        Publish(std::move(generation));
+        lock.unlock();
+        ReclaimRetired();
+    }
+    if (sealed_changed) {
+        merge_condition_.notify_all();
+    }
+}
+
+void ConcurrentSearchServer::UpdateStatus(const std::vector<int>& document_ids, DocumentStatus status) {
+    CheckNotReading();
+    std::lock_guard update_lock(update_mutex_);
+    std::unique_lock lock(write_mutex_);
+    std::vector<int> active_ids;
+    std::vector<std::vector<int>> sealed_ids;
+    SplitBySegment(document_ids, active_ids, sealed_ids);
+
+    auto generation = CopyGeneration();
+    bool sealed_changed = false;
+    for (size_t i = 0; i < sealed_ids.size(); ++i) {
+        if (sealed_ids[i].empty()) {
+            continue;
+        }
+        SealedSegment& segment = generation->sealed[i];
+        auto changes = std::make_shared<SegmentChanges>();
+        changes->removed_ids = segment.changes->removed_ids;
+
+        // Слияние двух упорядоченных списков; для одного документа побеждает новый статус.
+        const auto& statuses = segment.changes->statuses;
+        auto old_status = statuses.begin();
+        for (const int document_id : sealed_ids[i]) {
+            for (; old_status != statuses.end() && old_status->first < document_id; ++old_status) {
+                changes->statuses.push_back(*old_status);
+            }
+            if (old_status != statuses.end() && old_status->first == document_id) {
+                ++old_status;
+            }
+            changes->statuses.emplace_back(document_id, status);
+        }
+        changes->statuses.insert(changes->statuses.end(), old_status, statuses.end());
+
+        segment.changes = std::move(changes);
+        sealed_changed = true;
+    }
+
+    if (!active_ids.empty()) {
+        WriteActive(lock, [&](SearchServer& server) {
+            server.UpdateStatus(active_ids, status);
+            }, sealed_changed ? std::move(generation) : nullptr);
+    } else if (sealed_changed) {
+        Publish(std::move(generation));
+        lock.unlock();
+        ReclaimRetired();
+    }
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, result_count);
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ConcurrentSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    return MatchDocument(std::execution::seq, raw_query, document_id);
+}
+
+size_t ConcurrentSearchServer::GetDocumentCount() const {
+    return Read([](const Generation& generation) {
+        size_t document_count = generation.active->GetDocumentCount();
+        for (const SealedSegment& segment : generation.sealed) {
+            document_count += GetLiveDocumentCount(segment);
+        }
+        return document_count;
+        });
+}
+
+size_t ConcurrentSearchServer::GetSegmentCount() const {
+    return Read([](const Generation& generation) {
+        return generation.sealed.size() + 1;
+        });
+}
+
+uint64_t ConcurrentSearchServer::GetGeneration() const {
+    return Read([](const Generation& generation) {
+        return generation.number;
+        });
+}
+
+void ConcurrentSearchServer::WaitForMerges() {
+    CheckNotReading();
+    std::unique_lock lock(write_mutex_);
+    merge_condition_.wait(lock, [this] {
+        return !merging_ && PlanMerge().empty();
+        });
+}
+
+bool ConcurrentSearchServer::IsRemoved(const SealedSegment& segment, int document_id) {
+    const std::vector<int>& removed_ids = segment.changes->removed_ids;
+    return std::binary_search(removed_ids.begin(), removed_ids.end(), document_id);
+}
+
+DocumentStatus ConcurrentSearchServer::GetStatus(const SegmentChanges& changes, int document_id, DocumentStatus status) {
+    const auto it = std::lower_bound(changes.statuses.begin(), changes.statuses.end(), document_id,
+        [](const std::pair<int, DocumentStatus>& item, int id) {
+            return item.first < id;
+        });
+    return it != changes.statuses.end() && it->first == document_id ? it->second : status;
+}
+
+size_t ConcurrentSearchServer::GetLiveDocumentCount(const SealedSegment& segment) {
+    return segment.server->GetDocumentCount() - segment.changes->removed_ids.size();
+}
+
+const ConcurrentSearchServer::SealedSegment* ConcurrentSearchServer::FindSealedSegment(const Generation& generation, int document_id) {
+    for (const SealedSegment& segment : generation.sealed) {
+        const SearchServer& server = *segment.server;
+        if (server.ContainsDocument(document_id) && !IsRemoved(segment, document_id)) {
+            return &segment;
+        }
+    }
+    return nullptr;
+}
+
+void ConcurrentSearchServer::SplitBySegment(const std::vector<int>& document_ids, std::vector<int>& active_ids,
+    std::vector<std::vector<int>>& sealed_ids) const {
+    std::vector<int> sorted_ids = document_ids;
+    std::sort(sorted_ids.begin(), sorted_ids.end());
+    sorted_ids.erase(std::unique(sorted_ids.begin(), sorted_ids.end()), sorted_ids.end());
+
+    const SearchServer& active = *active_[write_index_];
+    const std::vector<SealedSegment>& sealed = published_->sealed;
+    sealed_ids.assign(sealed.size(), {});
+    for (const int document_id : sorted_ids) {
+        if (active.ContainsDocument(document_id)) {
+            active_ids.push_back(document_id);
+            continue;
+        }
+        for (size_t i = 0; i < sealed.size(); ++i) {
+            const SearchServer& server = *sealed[i].server;
+            if (server.ContainsDocument(document_id) && !IsRemoved(sealed[i], document_id)) {
+                sealed_ids[i].push_back(document_id);
+                break;
+            }
+        }
+    }
+}
+
+void ConcurrentSearchServer::CheckNotReading() const {
+    if (epoch_domain_.IsReading()) {
+        throw std::logic_error("Write inside a read of the same server"s);
+    }
+}
+
+void ConcurrentSearchServer::CheckNotSealed(int document_id) const {
+    if (FindSealedSegment(*published_, document_id) != nullptr) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+}
+
+void ConcurrentSearchServer::Publish(std::unique_ptr<const Generation> generation) {
+    current_.store(generation.get(), std::memory_order_seq_cst);
+    retired_.push_back(std::move(published_));
+    published_ = std::move(generation);
+}
+
+void ConcurrentSearchServer::ReclaimRetired() {
+    std::vector<std::unique_ptr<const Generation>> retired;
+    {
+        std::lock_guard lock(write_mutex_);
+        retired.swap(retired_);
+    }
+    // После ожидания эти поколения и всё, на что ссылались только они, никто не читает.
+    // Ждать нужно и при пустом списке: поколение, снятое вызывающим, мог забрать
+    // другой поток, который ещё ждёт.
+    epoch_domain_.Synchronize();
+}
+
+std::unique_ptr<ConcurrentSearchServer::Generation> ConcurrentSearchServer::CopyGeneration() const {
+    auto generation = std::make_unique<Generation>(*published_);
+    ++generation->number;
+    return generation;
+}
+
+template <typename Operation>
+void ConcurrentSearchServer::WriteActive(std::unique_lock<std::mutex>& lock, Operation operation, std::unique_ptr<Generation> generation) {
+    SearchServer& next = *active_[write_index_];
+    operation(next);
+
+    if (!generation) {
+        generation = CopyGeneration();
+    }
+    generation->active = &next;
+    Publish(std::move(generation));
+    lock.unlock();
+
+    // Прежнюю копию больше никто не читает. Фоновое слияние её не трогает,
+    // другие писатели ждут на update_mutex_.
+    ReclaimRetired();
+    operation(*active_[1 - write_index_]);
+
+    lock.lock();
+    write_index_ = 1 - write_index_;
+    const bool sealed = SealActiveIfFull();
+    lock.unlock();
+    if (sealed) {
+        ReclaimRetired();
+    }
+}
+
+bool ConcurrentSearchServer::SealActiveIfFull() {
+    if (published_->active->GetDocumentCount() < segment_size_) {
+        return false;
+    }
+
+    // Опубликованная копия становится запечатанным сегментом, вторая не нужна.
+    std::shared_ptr<const SearchServer> sealed(std::move(active_[1 - write_index_]));
+    active_[0] = std::make_unique<SearchServer>(stop_words_);
+    active_[1] = std::make_unique<SearchServer>(stop_words_);
+    write_index_ = 1;
+
+    auto generation = CopyGeneration();
+    generation->active = active_[0].get();
+    generation->sealed.push_back({ std::move(sealed), std::make_shared<const SegmentChanges>() });
+    Publish(std::move(generation));
+    merge_condition_.notify_all();
+    return true;
+}
+
+std::vector<ConcurrentSearchServer::SealedSegment> ConcurrentSearchServer::PlanMerge() const {
+    const std::vector<SealedSegment>& sealed = published_->sealed;
+
+    if (sealed.size() > MAX_SEALED_SEGMENTS) {
+        // Слияние самых маленьких держит число сегментов логарифмическим от размера индекса.
+        std::vector<SealedSegment> smallest = sealed;
+        std::partial_sort(smallest.begin(), smallest.begin() + MERGE_FACTOR, smallest.end(),
+            [](const SealedSegment& lhs, const SealedSegment& rhs) {
+                return GetLiveDocumentCount(lhs) < GetLiveDocumentCount(rhs);
+            });
+        smallest.resize(MERGE_FACTOR);
+        return smallest;
+    }
+
+    // Сегмент, где удалена больше чем половина документов, переписывается отдельно.
+    for (const SealedSegment& segment : sealed) {
+        if (segment.changes->removed_ids.size() * 2 > segment.server->GetDocumentCount()) {
+            return { segment };
+        }
+    }
+    return {};
+}
+
+void ConcurrentSearchServer::MergeLoop() {
+    std::unique_lock lock(write_mutex_);
+    while (true) {
+        std::vector<SealedSegment> segments;
+        merge_condition_.wait(lock, [&] {
+            return stopping_ || !(segments = PlanMerge()).empty();
+            });
+        if (stopping_) {
+            return;
+        }
+
+        merging_ = true;
+        lock.unlock();
+        std::shared_ptr<SearchServer> merged = MergeSegments(segments);
+        lock.lock();
+
+        InstallMerge(segments, std::move(merged));
+        merging_ = false;
+        merge_condition_.notify_all();
+
+        lock.unlock();
+        ReclaimRetired();
+        lock.lock();
+    }
+}
+
+std::shared_ptr<SearchServer> ConcurrentSearchServer::MergeSegments(const std::vector<SealedSegment>& segments) const {
+    std::vector<SearchServer::DocumentInput> documents;
+    for (const SealedSegment& segment : segments) {
+        for (auto& document : segment.server->ExportDocuments()) {
+            if (!IsRemoved(segment, document.id)) {
+                document.status = GetStatus(*segment.changes, document.id, document.status);
+                documents.push_back(std::move(document));
+            }
+        }
+    }
+    std::sort(documents.begin(), documents.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.id < rhs.id;
+        });
+
+    // Тексты указывают в сливаемые сегменты, которые живы, пока жив segments.
+    auto merged = std::make_shared<SearchServer>(stop_words_);
+    merged->AddDocuments(std::execution::par, documents);
+    return merged;
+}
+
+void ConcurrentSearchServer::InstallMerge(const std::vector<SealedSegment>& segments, std::shared_ptr<SearchServer> merged) {
+    auto generation = CopyGeneration();
+    auto& sealed = generation->sealed;
+
+    for (const SealedSegment& segment : segments) {
+        const auto current = std::find_if(sealed.begin(), sealed.end(), [&segment](const SealedSegment& item) {
+            return item.server == segment.server;
+            });
+        const SegmentChanges& changes = *current->changes;
+        if (&changes != segment.changes.get()) {
+            std::vector<int> removed_during_merge;
+            std::set_difference(changes.removed_ids.begin(), changes.removed_ids.end(),
+                segment.changes->removed_ids.begin(), segment.changes->removed_ids.end(), std::back_inserter(removed_during_merge));
+            merged->RemoveDocuments(removed_during_merge);
+            // Статусы идемпотентны, применяются все.
+            for (const auto& [document_id, status] : changes.statuses) {
+                merged->UpdateStatus({ document_id }, status);
+            }
+        }
+        sealed.erase(current);
+    }
+
+    if (merged->GetDocumentCount() > 0) {
+        sealed.push_back({ std::move(merged), std::make_shared<const SegmentChanges>() });
+    }
+    Publish(std::move(generation));
+}
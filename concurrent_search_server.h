@@ -0,0 +1,308 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "epoch_domain.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+/**
+	* Поисковый сервер, который можно менять во время запросов.
+	*
+	* Индекс разбит на сегменты - отдельные SearchServer. Новые документы попадают
+	* в небольшой активный сегмент; заполненный сегмент запечатывается и больше
+	* не меняется, а фоновый поток сливает запечатанные сегменты и при этом
+	* вычищает удалённые документы. Поэтому стоимость добавления не растёт с
+	* размером индекса. Удаление документа из запечатанного сегмента и смена его
+	* статуса лишь записываются рядом с сегментом, запросы их учитывают.
+	*
+	* Состав сегментов и их изменения образуют неизменяемое поколение индекса.
+	* Запросы читают опубликованное поколение, не беря блокировок: чтение - объявление
+	* эпохи и загрузка атомарного указателя. Писатель строит новое поколение,
+	* атомарно публикует его и, отпустив блокировку, ждёт, пока закончатся запросы,
+	* начатые на старом; только после этого старое поколение освобождается.
+	* Запрос от начала до конца видит одно поколение. Писатель ждёт только запросов
+	* к своему серверу, поэтому менять сервер изнутри чтения его же (например, из
+	* предиката FindTopDocuments) нельзя: такие вызовы бросают logic_error.
+	*
+	* Активный сегмент хранится в двух копиях: писатель меняет копию, которую никто
+	* не читает, публикует её и повторяет изменение на второй. Запечатанные сегменты
+	* хранятся в одном экземпляре и разделяются поколениями.
+	*
+	* IDF считается по всем сегментам сразу, поэтому релевантность сравнима между
+	* ними. Как и в Lucene, отмеченные удалёнными документы учитываются в IDF до
+	* слияния, которое их вычищает.
+	**/
+class ConcurrentSearchServer {
+public:
+    // Число документов, после которого активный сегмент запечатывается.
+    static constexpr size_t DEFAULT_SEGMENT_SIZE = 1 << 16;
+    // Больше запечатанных сегментов - и MERGE_FACTOR самых маленьких сливаются в один.
+    static constexpr size_t MAX_SEALED_SEGMENTS = 8;
+    static constexpr size_t MERGE_FACTOR = 4;
+
+    template <typename StringContainer>
+    explicit ConcurrentSearchServer(const StringContainer& stop_words, size_t segment_size = DEFAULT_SEGMENT_SIZE);
+
+    explicit ConcurrentSearchServer(const std::string& stop_words_text, size_t segment_size = DEFAULT_SEGMENT_SIZE);
+
+    explicit ConcurrentSearchServer(std::string_view stop_words_text, size_t segment_size = DEFAULT_SEGMENT_SIZE);
+
+    ~ConcurrentSearchServer();
+
+    ConcurrentSearchServer(const ConcurrentSearchServer&) = delete;
+    ConcurrentSearchServer& operator=(const ConcurrentSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void AddDocuments(const std::vector<SearchServer::DocumentInput>& documents);
+
+    void AddDocuments(std::execution::sequenced_policy seq, const std::vector<SearchServer::DocumentInput>& documents);
+
+    void AddDocuments(std::execution::parallel_policy par, const std::vector<SearchServer::DocumentInput>& documents);
+
+    void RemoveDocument(int document_id);
+
+    void RemoveDocument(std::execution::sequenced_policy seq, int document_id);
+
+    void RemoveDocument(std::execution::parallel_policy par, int document_id);
+
+    // Пакетные изменения публикуются одним поколением.
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    void RemoveDocuments(std::execution::sequenced_policy seq, const std::vector<int>& document_ids);
+
+    void RemoveDocuments(std::execution::parallel_policy par, const std::vector<int>& document_ids);
+
+    void UpdateStatus(const std::vector<int>& document_ids, DocumentStatus status);
+
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t result_count = SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t result_count = SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+        size_t result_count = SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+        size_t result_count = SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // Найденные слова указывают в raw_query и живут, пока жива строка запроса.
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    size_t GetDocumentCount() const;
+
+    // Число сегментов, включая активный.
+    size_t GetSegmentCount() const;
+
+    // Номер опубликованного поколения, растёт с каждым изменением индекса.
+    uint64_t GetGeneration() const;
+
+    // Ждёт, пока фоновый поток выполнит все нужные слияния.
+    void WaitForMerges();
+
+private:
+    // Изменения запечатанного сегмента, оба списка по возрастанию идентификатора.
+    struct SegmentChanges {
+        std::vector<int> removed_ids;
+        std::vector<std::pair<int, DocumentStatus>> statuses;
+    };
+
+    struct SealedSegment {
+        std::shared_ptr<const SearchServer> server;
+        // Заменяется целиком при каждом изменении.
+        std::shared_ptr<const SegmentChanges> changes;
+    };
+
+    struct Generation {
+        uint64_t number = 0;
+        const SearchServer* active = nullptr;
+        std::vector<SealedSegment> sealed;
+    };
+
+    const std::set<std::string, std::less<>> stop_words_;
+    const size_t segment_size_;
+
+    std::atomic<const Generation*> current_{ nullptr };
+    EpochDomain epoch_domain_;
+
+    // Писатели активного сегмента идут по одному: пока писатель ждёт читателей,
+    // вторая копия сегмента ещё не обновлена. Берётся до write_mutex_.
+    std::mutex update_mutex_;
+    std::array<std::unique_ptr<SearchServer>, 2> active_;
+    size_t write_index_ = 1;    // копия активного сегмента для следующей записи
+
+    // Поля ниже меняются только под write_mutex_. Читателей под ним не ждут.
+    std::mutex write_mutex_;
+    std::unique_ptr<const Generation> published_;
+    // Снятые с публикации поколения, которые ещё могут читать запросы.
+    std::vector<std::unique_ptr<const Generation>> retired_;
+
+    std::thread merge_thread_;
+    std::condition_variable merge_condition_;
+    bool merging_ = false;
+    bool stopping_ = false;
+
+    void Start();
+
+    static bool IsRemoved(const SealedSegment& segment, int document_id);
+
+    // Статус документа с учётом изменений сегмента.
+    static DocumentStatus GetStatus(const SegmentChanges& changes, int document_id, DocumentStatus status);
+
+    static size_t GetLiveDocumentCount(const SealedSegment& segment);
+
+    // Сегмент, где документ жив, или nullptr.
+    static const SealedSegment* FindSealedSegment(const Generation& generation, int document_id);
+
+    // Бросает logic_error, если текущий поток читает этот сервер: писатель ждал бы сам себя.
+    void CheckNotReading() const;
+
+    // Бросает invalid_argument, если документ с таким идентификатором уже есть в запечатанном сегменте.
+    void CheckNotSealed(int document_id) const;
+
+    // Публикует поколение под write_mutex_, предыдущее уходит в retired_.
+    void Publish(std::unique_ptr<const Generation> generation);
+
+    // Без write_mutex_ ждёт окончания запросов к поколениям, снятым до вызова,
+    // и освобождает их.
+    void ReclaimRetired();
+
+    // Новое поколение с прежними сегментами.
+    std::unique_ptr<Generation> CopyGeneration() const;
+
+    // Применяет operation к обеим копиям активного сегмента и публикует generation
+    // (по умолчанию - копию текущего) с изменённым активным сегментом. Если operation
+    // бросает исключение на первой копии, поколение не публикуется; операции сервера
+    // проверяют аргументы до изменений. Вызывается под update_mutex_ и взятым lock
+    // на write_mutex_; возвращается с отпущенным lock.
+    template <typename Operation>
+    void WriteActive(std::unique_lock<std::mutex>& lock, Operation operation, std::unique_ptr<Generation> generation = nullptr);
+
+    // Раскладывает идентификаторы по сегментам: живые в активном - в active_ids,
+    // в запечатанных - по индексу сегмента. Неизвестные пропускаются.
+    void SplitBySegment(const std::vector<int>& document_ids, std::vector<int>& active_ids,
+        std::vector<std::vector<int>>& sealed_ids) const;
+
+    // Возвращает, запечатан ли сегмент.
+    bool SealActiveIfFull();
+
+    template <typename ExecutionPolicy>
+    void RemoveDocumentBatch(ExecutionPolicy policy, const std::vector<int>& document_ids);
+
+    // Сегменты для следующего слияния, пусто - сливать нечего.
+    std::vector<SealedSegment> PlanMerge() const;
+
+    void MergeLoop();
+
+    // Собирает живые документы сегментов в новый сервер; вызывается без блокировки.
+    std::shared_ptr<SearchServer> MergeSegments(const std::vector<SealedSegment>& segments) const;
+
+    // Заменяет слитые сегменты результатом. Изменения, сделанные во время слияния,
+    // применяются к нему перед публикацией.
+    void InstallMerge(const std::vector<SealedSegment>& segments, std::shared_ptr<SearchServer> merged);
+
+    // Вызывает reader для текущего поколения.
+    template <typename Reader>
+    auto Read(Reader reader) const;
+};
+
+template <typename StringContainer>
+ConcurrentSearchServer::ConcurrentSearchServer(const StringContainer& stop_words, size_t segment_size)
+    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    , segment_size_(segment_size)
+{
+    Start();
+}
+
+template <typename Reader>
+auto ConcurrentSearchServer::Read(Reader reader) const {
+    EpochDomain::ReadGuard guard(epoch_domain_);
+    return reader(*current_.load(std::memory_order_seq_cst));
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+    DocumentPredicate document_predicate, size_t result_count) const {
+    return Read([&](const Generation& generation) {
+        SearchServer::CorpusStatistics corpus;
+        generation.active->AddCorpusStatistics(raw_query, corpus);
+        for (const SealedSegment& segment : generation.sealed) {
+            segment.server->AddCorpusStatistics(raw_query, corpus);
+        }
+
+        TopDocuments top_documents(result_count);
+        for (const Document& document : generation.active->FindTopDocuments(policy, raw_query, corpus, document_predicate, result_count)) {
+            top_documents.Push(document);
+        }
+        for (const SealedSegment& segment : generation.sealed) {
+            const SegmentChanges& changes = *segment.changes;
+            const std::vector<Document> documents = changes.removed_ids.empty() && changes.statuses.empty()
+                ? segment.server->FindTopDocuments(policy, raw_query, corpus, document_predicate, result_count)
+                : segment.server->FindTopDocuments(policy, raw_query, corpus,
+                    [&changes, document_predicate](int document_id, DocumentStatus status, int rating) {
+                        return !std::binary_search(changes.removed_ids.begin(), changes.removed_ids.end(), document_id)
+                            && document_predicate(document_id, GetStatus(changes, document_id, status), rating);
+                    }, result_count);
+            for (const Document& document : documents) {
+                top_documents.Push(document);
+            }
+        }
+        return top_documents.Extract();
+        });
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+    size_t result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+    size_t result_count) const {
+    return FindTopDocuments(policy, raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+        }, result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> ConcurrentSearchServer::MatchDocument(ExecutionPolicy&& policy,
+    std::string_view raw_query, int document_id) const {
+    return Read([&](const Generation& generation) {
+        const SealedSegment* segment = FindSealedSegment(generation, document_id);
+        if (segment == nullptr) {
+            // Неизвестный идентификатор: активный сегмент бросит out_of_range.
+            return generation.active->MatchDocument(policy, raw_query, document_id);
+        }
+        auto [words, status] = segment->server->MatchDocument(policy, raw_query, document_id);
+        return std::tuple{ std::move(words), GetStatus(*segment->changes, document_id, status) };
+        });
+}
@@ -0,0 +1,123 @@
+#include "epoch_domain.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::string_literals;
+
+struct EpochDomain::State {
+    std::atomic<uint64_t> epoch{ 1 };
+    // Ячейки не удаляются до разрушения состояния: после завершения потока ячейку занимает следующий.
+    std::atomic<ReaderSlot*> slots{ nullptr };
+    std::atomic<bool> alive{ true };
+
+    ~State() {
+        for (ReaderSlot* slot = slots.load(std::memory_order_acquire); slot != nullptr;) {
+            ReaderSlot* next = slot->next;
+            delete slot;
+            slot = next;
+        }
+    }
+
+    ReaderSlot* AcquireSlot() {
+        for (ReaderSlot* slot = slots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+            bool expected = false;
+            if (!slot->in_use.load(std::memory_order_relaxed)
+                && slot->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return slot;
+            }
+        }
+
+        ReaderSlot* slot = new ReaderSlot;
+        slot->in_use.store(true, std::memory_order_relaxed);
+        slot->next = slots.load(std::memory_order_relaxed);
+        while (!slots.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return slot;
+    }
+};
+
+// Ячейки потока во всех доменах, где он читал; обычно их одна-две.
+struct EpochDomain::ThreadSlots {
+    struct Item {
+        std::shared_ptr<State> state;
+        ReaderSlot* slot = nullptr;
+    };
+
+    std::vector<Item> items;
+
+    ~ThreadSlots() {
+        for (const Item& item : items) {
+            item.slot->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+EpochDomain::EpochDomain()
+    : state_(std::make_shared<State>())
+{
+}
+
+EpochDomain::~EpochDomain() {
+    state_->alive.store(false, std::memory_order_release);
+}
+
+EpochDomain::ReadGuard::ReadGuard(const EpochDomain& domain)
+    : slot_(*domain.FindThreadSlot(true))
+{
+    if (slot_.depth++ == 0) {
+        // Последовательная согласованность упорядочивает объявление эпохи перед
+        // последующим чтением опубликованного указателя (см. Synchronize).
+        slot_.epoch.store(domain.state_->epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+}
+
+EpochDomain::ReadGuard::~ReadGuard() {
+    if (--slot_.depth == 0) {
+        slot_.epoch.store(IDLE, std::memory_order_release);
+    }
+}
+
+void EpochDomain::Synchronize() {
+    if (IsReading()) {
+        throw std::logic_error("Synchronize inside a read of the same domain"s);
+    }
+
+    // Читатель с эпохой не меньше target объявил её после публикации и видит новые данные.
+    const uint64_t target = state_->epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    for (ReaderSlot* slot = state_->slots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+        while (slot->epoch.load(std::memory_order_seq_cst) < target) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool EpochDomain::IsReading() const {
+    const ReaderSlot* slot = FindThreadSlot(false);
+    return slot != nullptr && slot->depth > 0;
+}
+
+EpochDomain::ReaderSlot* EpochDomain::FindThreadSlot(bool acquire) const {
+    thread_local ThreadSlots thread_slots;
+    std::vector<ThreadSlots::Item>& items = thread_slots.items;
+    for (const ThreadSlots::Item& item : items) {
+        if (item.state == state_) {
+            return item.slot;
+        }
+    }
+    if (!acquire) {
+        return nullptr;
+    }
+
+    // Ячейки разрушенных доменов больше не нужны.
+    items.erase(std::remove_if(items.begin(), items.end(), [](const ThreadSlots::Item& item) {
+        return !item.state->alive.load(std::memory_order_acquire);
+        }), items.end());
+
+    ReaderSlot* slot = state_->AcquireSlot();
+    items.push_back({ state_, slot });
+    return slot;
+}
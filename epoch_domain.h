@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+/**
+	* Учёт читателей для публикации данных без блокировок (RCU). Читатель на
+	* время чтения объявляет текущую эпоху в своей ячейке: это одна запись в
+	* атомарную переменную, без мьютексов и ожидания. Писатель, опубликовав новую
+	* версию данных, вызывает Synchronize и дожидается только тех читателей,
+	* которые могли увидеть старую версию; после этого её можно менять или удалять.
+	*
+	* У каждого набора данных свой домен, и писатель ждёт только читателей своего
+	* домена. Ячейка читателя закрепляется за парой поток-домен при первом чтении
+	* и освобождается при завершении потока.
+	**/
+class EpochDomain {
+public:
+    struct ReaderSlot;
+
+    EpochDomain();
+    ~EpochDomain();
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // Чтение от создания до разрушения объекта. Вложенные чтения в одном потоке
+    // допустимы: ячейку занимает внешнее, его эпоха защищает и вложенные.
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const EpochDomain& domain);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        ReaderSlot& slot_;
+    };
+
+    // Ждёт окончания чтений, начатых до вызова. Данные, которые писатель заменил
+    // до вызова, после возврата никто не читает. Изнутри чтения этого же домена
+    // ожидание не закончилось бы никогда, поэтому такой вызов бросает logic_error.
+    void Synchronize();
+
+    // Идёт ли в текущем потоке чтение этого домена.
+    bool IsReading() const;
+
+    // Ячейка читателя: выровнена по строке кэша, чтобы потоки не делили строки.
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{ IDLE };
+        std::atomic<bool> in_use{ false };
+        uint32_t depth = 0;    // вложенность чтений, меняет только поток-владелец
+        ReaderSlot* next = nullptr;
+    };
+
+private:
+    static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+    struct State;
+    struct ThreadSlots;
+
+    // Состояние переживает домен, пока на его ячейки ссылаются потоки.
+    std::shared_ptr<State> state_;
+
+    // Ячейка потока в этом домене; без acquire - nullptr, если поток здесь ещё не читал.
+    ReaderSlot* FindThreadSlot(bool acquire) const;
+};
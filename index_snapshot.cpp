@@ -0,0 +1,162 @@
+#include "index_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr uint64_t SECTION_ALIGNMENT = 8;
+
+uint64_t AlignOffset(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+} // namespace
+
+SnapshotWriter::SnapshotWriter(const std::string& path)
+    : output_(path, std::ios::binary | std::ios::trunc)
+{
+    if (!output_) {
+        throw std::runtime_error("Can't create snapshot "s + path);
+    }
+    std::copy(std::begin(SnapshotHeader::MAGIC), std::end(SnapshotHeader::MAGIC), header_.magic);
+    header_.format_version = SnapshotHeader::FORMAT_VERSION;
+    header_.section_count = static_cast<uint32_t>(SnapshotSection::COUNT);
+
+    // Место под заголовок, настоящий пишется в Finish.
+    const SnapshotHeader placeholder;
+    output_.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+    offset_ = sizeof(placeholder);
+}
+
+void SnapshotWriter::WriteSection(SnapshotSection section, const void* data, size_t size) {
+    static const char padding[SECTION_ALIGNMENT] = {};
+
+    const uint64_t section_offset = AlignOffset(offset_);
+    output_.write(padding, static_cast<std::streamsize>(section_offset - offset_));
+    output_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    offset_ = section_offset + size;
+
+    header_.sections[static_cast<size_t>(section)] = { section_offset, size };
+}
+
+void SnapshotWriter::SetFlags(uint32_t flags) {
+    header_.flags = flags;
+}
+
+void SnapshotWriter::Finish() {
+    output_.seekp(0);
+    output_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    output_.flush();
+    if (!output_) {
+        throw std::runtime_error("Can't write snapshot"s);
+    }
+}
+
+IndexSnapshot::IndexSnapshot(const std::string& path) {
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Can't open snapshot "s + path);
+    }
+    file_handle_ = file;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        Unmap();
+        throw std::runtime_error("Can't read snapshot "s + path);
+    }
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    if (size_ > 0) {
+        mapping_handle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle_ != nullptr) {
+            data_ = static_cast<const char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (data_ == nullptr) {
+            Unmap();
+            throw std::runtime_error("Can't map snapshot "s + path);
+        }
+    }
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open snapshot "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Can't read snapshot "s + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Can't map snapshot "s + path);
+        }
+        data_ = static_cast<const char*>(mapped);
+    }
+    // Отображение не зависит от дескриптора.
+    close(fd);
+#endif
+
+    header_ = reinterpret_cast<const SnapshotHeader*>(data_);
+    bool valid = size_ >= sizeof(SnapshotHeader)
+        && std::equal(std::begin(SnapshotHeader::MAGIC), std::end(SnapshotHeader::MAGIC), header_->magic)
+        && header_->format_version == SnapshotHeader::FORMAT_VERSION
+        && header_->section_count == static_cast<uint32_t>(SnapshotSection::COUNT);
+    for (size_t i = 0; valid && i < static_cast<size_t>(SnapshotSection::COUNT); ++i) {
+        const auto& entry = header_->sections[i];
+        valid = entry.offset <= size_ && entry.size <= size_ - entry.offset;
+    }
+    if (!valid) {
+        Unmap();
+        throw std::runtime_error("File "s + path + " is not a compatible index snapshot"s);
+    }
+}
+
+IndexSnapshot::~IndexSnapshot() {
+    Unmap();
+}
+
+uint32_t IndexSnapshot::GetFlags() const {
+    return header_->flags;
+}
+
+size_t IndexSnapshot::GetFileSize() const {
+    return size_;
+}
+
+void IndexSnapshot::Unmap() {
+#ifdef _WIN32
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_ != nullptr) {
+        CloseHandle(mapping_handle_);
+    }
+    if (file_handle_ != nullptr) {
+        CloseHandle(file_handle_);
+    }
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    header_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+	* Бинарный снимок индекса. Файл состоит из заголовка с таблицей разделов
+	* и самих разделов, выровненных по 8 байт. Раздел - плотный массив значений
+	* фиксированного размера, поэтому после отображения файла в память данные
+	* читаются на месте, без разбора и копирования.
+	**/
+enum class SnapshotSection : uint32_t {
+    STOP_WORDS,
+    TERM_SLOTS,
+    TERM_OFFSETS,
+    TERM_BYTES,
+    TERM_MAX_FREQS,
+    TERM_IDFS,
+    POSTING_OFFSETS,
+    POSTINGS,
+    DOCUMENT_TERM_OFFSETS,
+    DOCUMENT_TERMS,
+    DOCUMENT_IDS,
+    DOCUMENT_RATINGS,
+    DOCUMENT_STATUSES,
+    SORTED_IDS,
+    SORTED_ORDINALS,
+    // Разделы сжатого формата (флаг COMPRESSED_POSTINGS): вместо POSTINGS и DOCUMENT_TERMS.
+    POSTING_BLOCK_OFFSETS,
+    POSTING_BLOCKS,
+    POSTING_DATA,
+    TERM_FREQ_CODEBOOK,
+    DOCUMENT_TERM_IDS,
+    COUNT,
+};
+
+struct SnapshotHeader {
+    static constexpr char MAGIC[8] = { 'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P' };
+    // Увеличивается при любом изменении состава или раскладки разделов.
+    static constexpr uint32_t FORMAT_VERSION = 2;
+
+    // Флаги снимка.
+    static constexpr uint32_t COMPRESSED_POSTINGS = 1;
+
+    struct SectionEntry {
+        uint64_t offset = 0;
+        uint64_t size = 0;    // в байтах
+    };
+
+    char magic[8] = {};
+    uint32_t format_version = 0;
+    uint32_t section_count = 0;
+    uint32_t flags = 0;
+    uint32_t reserved = 0;
+    SectionEntry sections[static_cast<size_t>(SnapshotSection::COUNT)] = {};
+};
+
+// Пишет снимок последовательно: разделы в любом порядке, заголовок - в Finish.
+// Ошибки ввода-вывода бросают runtime_error.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path);
+
+    void WriteSection(SnapshotSection section, const void* data, size_t size);
+
+    template <typename T>
+    void WriteSection(SnapshotSection section, const std::vector<T>& values) {
+        WriteSection(section, values.data(), values.size() * sizeof(T));
+    }
+
+    void SetFlags(uint32_t flags);
+
+    void Finish();
+
+private:
+    std::ofstream output_;
+    SnapshotHeader header_;
+    uint64_t offset_ = 0;
+};
+
+// Снимок, отображённый в память только для чтения. Данные доступны, пока жив объект.
+class IndexSnapshot {
+public:
+    // Бросает runtime_error, если файл не открывается или не является снимком этой версии.
+    explicit IndexSnapshot(const std::string& path);
+    ~IndexSnapshot();
+
+    IndexSnapshot(const IndexSnapshot&) = delete;
+    IndexSnapshot& operator=(const IndexSnapshot&) = delete;
+
+    template <typename T>
+    struct Span {
+        const T* data = nullptr;
+        size_t size = 0;
+    };
+
+    template <typename T>
+    Span<T> GetSection(SnapshotSection section) const {
+        using namespace std::string_literals;
+
+        const auto& entry = header_->sections[static_cast<size_t>(section)];
+        if (entry.size % sizeof(T) != 0 || entry.offset % alignof(T) != 0) {
+            throw std::runtime_error("Snapshot section "s + std::to_string(static_cast<uint32_t>(section)) + " is malformed"s);
+        }
+        return { reinterpret_cast<const T*>(data_ + entry.offset), static_cast<size_t>(entry.size / sizeof(T)) };
+    }
+
+    uint32_t GetFlags() const;
+
+    size_t GetFileSize() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const SnapshotHeader* header_ = nullptr;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+
+    void Unmap();
+};
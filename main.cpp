@@ -1,6 +1,6 @@
 #include "search_server.h"
-//#include "log_duration.h"
 #include "process_queries.h"
+#include "stage_profiler.h"
 
 #include <execution>
 #include <iostream>
@@ -55,7 +55,7 @@ vector<string> GenerateQueries(mt19937& generator, const vector<string>& diction
 
 template <typename ExecutionPolicy>
 void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
-   // LOG_DURATION(mark);
+    StageProfiler::Reset();
     double total_relevance = 0;
     for (const string_view query : queries) {
         for (const auto& document : search_server.FindTopDocuments(policy, query)) {
@@ -63,6 +63,10 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
         }
     }
     cout << total_relevance << endl;
+    if (StageProfiler::ENABLED) {
+        cout << mark << ":"s << endl;
+        StageProfiler::Dump(cout);
+    }
 }
 
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
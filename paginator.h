@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <iterator>
 #include <vector>
 
 template <typename Iterator>
@@ -9,7 +10,7 @@ public:
     IteratorRange(Iterator begin, Iterator end)
         : first_(begin)
         , last_(end)
-        , size_(distance(first_, last_)) {
+        , size_(std::distance(first_, last_)) {
     }
 
     Iterator begin() const {
@@ -33,9 +34,9 @@ template <typename Iterator>
 class Paginator {
 public:
     Paginator(Iterator begin, Iterator end, size_t page_size) {
-        for (size_t left = distance(begin, end); left > 0;) {
+        for (size_t left = std::distance(begin, end); left > 0;) {
             const size_t current_page_size = std::min(page_size, left);
-            const Iterator current_page_end = next(begin, current_page_size);
+            const Iterator current_page_end = std::next(begin, current_page_size);
             pages_.push_back({begin, current_page_end});
 
             left -= current_page_size;
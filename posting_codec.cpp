@@ -0,0 +1,113 @@
+#include "posting_codec.h"
+
+#include <algorithm>
+
+namespace {
+
+uint8_t GetBitWidth(uint32_t value) {
+    uint8_t bits = 0;
+    while (value != 0) {
+        ++bits;
+        value >>= 1;
+    }
+    return bits;
+}
+
+// Значения шириной до 32 бит пишутся с младших битов слова и могут переходить в следующее.
+void WriteBits(uint64_t* words, uint64_t position, uint32_t value, uint8_t bits) {
+    const uint64_t word = position >> 6;
+    const uint32_t shift = position & 63;
+    words[word] |= static_cast<uint64_t>(value) << shift;
+    if (shift + bits > 64) {
+        words[word + 1] |= static_cast<uint64_t>(value) >> (64 - shift);
+    }
+}
+
+// Последовательное чтение значений одной ширины: слово загружается один раз.
+class BitReader {
+public:
+    explicit BitReader(const uint64_t* words)
+        : words_(words) {
+    }
+
+    uint32_t Read(uint8_t bits) {
+        const uint64_t mask = (uint64_t{ 1 } << bits) - 1;
+        if (available_ >= bits) {
+            const uint64_t value = buffer_ & mask;
+            buffer_ >>= bits;
+            available_ -= bits;
+            return static_cast<uint32_t>(value);
+        }
+        const uint64_t next = *words_++;
+        const uint64_t value = (buffer_ | (next << available_)) & mask;
+        buffer_ = next >> (bits - available_);
+        available_ = 64 - (bits - available_);
+        return static_cast<uint32_t>(value);
+    }
+
+private:
+    const uint64_t* words_;
+    uint64_t buffer_ = 0;
+    uint32_t available_ = 0;
+};
+
+} // namespace
+
+PostingBlock EncodePostingBlock(const uint32_t* ordinals, const uint32_t* codes, size_t count, std::vector<uint64_t>& data) {
+    PostingBlock block;
+    block.first_ordinal = ordinals[0];
+    block.last_ordinal = ordinals[count - 1];
+    block.data_offset = data.size();
+    block.count = static_cast<uint32_t>(count);
+
+    // Номера строго возрастают, поэтому хранится разность минус один.
+    uint32_t max_delta = 0;
+    for (size_t i = 1; i < count; ++i) {
+        max_delta = std::max(max_delta, ordinals[i] - ordinals[i - 1] - 1);
+    }
+    block.delta_bits = GetBitWidth(max_delta);
+    block.code_bits = GetBitWidth(*std::max_element(codes, codes + count));
+
+    const uint64_t bit_count = (count - 1) * block.delta_bits + count * block.code_bits;
+    data.resize(data.size() + (bit_count + 63) / 64, 0);
+    uint64_t* words = data.data() + block.data_offset;
+
+    uint64_t position = 0;
+    if (block.delta_bits > 0) {
+        for (size_t i = 1; i < count; ++i, position += block.delta_bits) {
+            WriteBits(words, position, ordinals[i] - ordinals[i - 1] - 1, block.delta_bits);
+        }
+    }
+    if (block.code_bits > 0) {
+        for (size_t i = 0; i < count; ++i, position += block.code_bits) {
+            WriteBits(words, position, codes[i], block.code_bits);
+        }
+    }
+    return block;
+}
+
+void DecodePostingBlock(const PostingBlock& block, const uint64_t* data, uint32_t* ordinals, uint32_t* codes) {
+    BitReader reader(data + block.data_offset);
+    const size_t count = block.count;
+
+    ordinals[0] = block.first_ordinal;
+    if (block.delta_bits > 0) {
+        for (size_t i = 1; i < count; ++i) {
+            ordinals[i] = ordinals[i - 1] + reader.Read(block.delta_bits) + 1;
+        }
+    }
+    else {
+        for (size_t i = 1; i < count; ++i) {
+            ordinals[i] = ordinals[i - 1] + 1;
+        }
+    }
+
+    if (block.code_bits > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            codes[i] = reader.Read(block.code_bits);
+        }
+    }
+    else {
+        std::fill(codes, codes + count, 0u);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+	* Сжатие списков словопозиций блоками по POSTING_BLOCK_SIZE элементов.
+	* В блоке хранятся разности соседних порядковых номеров и коды TF; каждая
+	* из двух последовательностей упакована битами одной ширины на весь блок,
+	* поэтому распаковка - простой цикл без ветвлений по значениям.
+	* Заголовки блоков с первым и последним номером служат таблицей переходов:
+	* нужный блок находится по ним без распаковки остальных.
+	**/
+static constexpr size_t POSTING_BLOCK_SIZE = 128;
+
+struct PostingBlock {
+    uint32_t first_ordinal = 0;
+    uint32_t last_ordinal = 0;
+    uint64_t data_offset = 0;    // в 64-битных словах
+    uint32_t count = 0;
+    uint8_t delta_bits = 0;
+    uint8_t code_bits = 0;
+    uint16_t reserved = 0;
+};
+
+// Дописывает в data блок из count (от 1 до POSTING_BLOCK_SIZE) строго возрастающих
+// номеров и их кодов TF и возвращает его заголовок.
+PostingBlock EncodePostingBlock(const uint32_t* ordinals, const uint32_t* codes, size_t count, std::vector<uint64_t>& data);
+
+// Распаковывает блок; ordinals и codes вмещают не меньше block.count элементов.
+void DecodePostingBlock(const PostingBlock& block, const uint64_t* data, uint32_t* ordinals, uint32_t* codes);
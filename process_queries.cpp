@@ -2,8 +2,84 @@
 #include <execution>
 #include <algorithm>
 #include <list>
+#include <atomic>
+#include <exception>
+#include <mutex>
 
 #include "process_queries.h"
+#include "work_stealing_pool.h"
+
+namespace {
+
+// Запрос с таким числом словопозиций считается по окнам документов задачами того же пула.
+constexpr size_t MIN_PARALLEL_QUERY_POSTING_COUNT = 1 << 16;
+
+// Общий пул: потоки создаются один раз на процесс.
+WorkStealingPool& GetQueryPool() {
+    static WorkStealingPool pool;
+    return pool;
+}
+
+struct QueryBatch {
+    QueryBatch(const SearchServer& search_server, const std::vector<std::string>& queries, const QueryResultCallback& callback)
+        : search_server(search_server)
+        , queries(queries)
+        , callback(callback) {
+    }
+
+    const SearchServer& search_server;
+    const std::vector<std::string>& queries;
+    const QueryResultCallback& callback;
+    std::mutex callback_mutex;
+    std::atomic<size_t> running_task_count{ 1 };
+    std::atomic<bool> failed{ false };
+    std::exception_ptr error;    // первая ошибка, пишется под callback_mutex
+};
+
+void ProcessQuery(WorkStealingPool& pool, QueryBatch& batch, size_t index) {
+    if (batch.failed.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    try {
+        const auto query = batch.search_server.PrepareSearchQuery(batch.queries[index]);
+        std::vector<Document> documents = batch.search_server.GetPostingCount(query) < MIN_PARALLEL_QUERY_POSTING_COUNT
+            ? batch.search_server.FindTopDocuments(std::execution::seq, query, DocumentStatus::ACTUAL)
+            : batch.search_server.FindTopDocuments(pool.GetExecutionPolicy(), query, DocumentStatus::ACTUAL);
+
+        std::lock_guard lock(batch.callback_mutex);
+        if (!batch.failed.load(std::memory_order_relaxed)) {
+            batch.callback(index, std::move(documents));
+        }
+    }
+    catch (...) {
+        std::lock_guard lock(batch.callback_mutex);
+        if (!batch.failed.exchange(true)) {
+            batch.error = std::current_exception();
+        }
+    }
+}
+
+// Вторая половина диапазона уходит в очередь потока, где её может забрать
+// простаивающий поток, первая обрабатывается сразу. В очередях остаётся
+// логарифм от числа запросов задач, а не по задаче на запрос.
+void ProcessRange(WorkStealingPool& pool, QueryBatch& batch, size_t first, size_t last) {
+    while (last - first > 1) {
+        const size_t middle = first + (last - first) / 2;
+        batch.running_task_count.fetch_add(1);
+        pool.Submit([&pool, &batch, middle, last] {
+            ProcessRange(pool, batch, middle, last);
+            });
+        last = middle;
+    }
+    ProcessQuery(pool, batch, first);
+
+    if (batch.running_task_count.fetch_sub(1) == 1) {
+        pool.Notify();
+    }
+}
+
+} // namespace
 
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
@@ -11,29 +87,61 @@ std::vector<std::vector<Document>> ProcessQueries(
 {
     std::vector<std::vector<Document>> documents_lists(queries.size());
 
-    std::transform(
-        std::execution::par,
-        queries.begin(), queries.end(),
-        documents_lists.begin(),
-        [&search_server](const std::string& query) { return search_server.FindTopDocuments(query); }
-    );
+    ProcessQueries(search_server, queries, [&documents_lists](size_t query_index, std::vector<Document> documents) {
+        documents_lists[query_index] = std::move(documents);
+        });
 
     return documents_lists;
 }
 
+void ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    const QueryResultCallback& callback)
+{
+    if (queries.empty()) {
+        return;
+    }
+
+    WorkStealingPool& pool = GetQueryPool();
+    QueryBatch batch{ search_server, queries, callback };
+    pool.Submit([&pool, &batch, size = queries.size()] {
+        ProcessRange(pool, batch, 0, size);
+        });
+    pool.Wait([&batch] {
+        return batch.running_task_count.load() == 0;
+        });
+
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries) 
 {
-    std::vector<std::vector<Document>> q_results = ProcessQueries(search_server, queries);
-    std::vector<Document> result;
+    // Выдача запроса не длиннее DEFAULT_RESULT_DOCUMENT_COUNT: запрос пишет её прямо
+    // в свой участок общего буфера, а затем участки сдвигаются встык.
+    constexpr size_t max_count = SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT;
+    std::vector<Document> result(queries.size() * max_count);
+    std::vector<size_t> counts(queries.size());
 
-    for(const auto& item : q_results){
-        for(const auto& i : item){
-            result.push_back(i);
+    ProcessQueries(search_server, queries, [&](size_t query_index, std::vector<Document> documents) {
+        std::move(documents.begin(), documents.end(), result.begin() + query_index * max_count);
+        counts[query_index] = documents.size();
+        });
+
+    // offset - сумма длин выдач предыдущих запросов, не больше начала участка запроса.
+    size_t offset = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        const auto first = result.begin() + i * max_count;
+        if (offset != i * max_count) {
+            std::move(first, first + counts[i], result.begin() + offset);
         }
+        offset += counts[i];
     }
-
+    result.resize(offset);
 
     return result;
 }
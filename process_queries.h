@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include "search_server.h"
 
 /**
@@ -9,6 +11,24 @@ std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+// Получает выдачу запроса по мере готовности: номер запроса в queries и документы.
+using QueryResultCallback = std::function<void(size_t query_index, std::vector<Document> documents)>;
+
+// Запросы выполняются задачами пула с перехватом работы, выдача передаётся в callback
+// в порядке готовности и не накапливается. callback вызывается из потоков пула, но
+// не одновременно. Запросы с длинными списками словопозиций делятся на задачи того
+// же пула по окнам документов.
+// Если запрос некорректен, оставшиеся запросы не выполняются, а исключение
+// выбрасывается после завершения уже начатых. Из callback нельзя вызывать
+// ProcessQueries: ожидая вложенный вызов, поток взял бы задачу внешнего и
+// заблокировался на его же callback.
+void ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    const QueryResultCallback& callback);
+
+// Выдачи всех запросов подряд в порядке queries. Выдача каждого запроса пишется
+// сразу в общий вектор, промежуточные векторы по запросам не собираются.
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries);
\ No newline at end of file
+    const std::vector<std::string>& queries);
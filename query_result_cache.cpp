@@ -0,0 +1,86 @@
+#include "query_result_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+QueryResultCache::QueryResultCache(size_t capacity)
+    : shard_capacity_(std::max<size_t>(1, (capacity + SHARD_COUNT - 1) / SHARD_COUNT))
+    , shards_(SHARD_COUNT)
+{
+}
+
+std::string QueryResultCache::MakeKey(const std::vector<std::string_view>& plus_words, const std::vector<std::string_view>& minus_words,
+    DocumentStatus status, size_t result_count) {
+    // Слова не содержат управляющих символов, поэтому '\0' и '\1' однозначно их разделяют.
+    std::string key = std::to_string(static_cast<int>(status)) + ' ' + std::to_string(result_count);
+    for (std::string_view word : plus_words) {
+        key += '\0';
+        key += word;
+    }
+    key += '\1';
+    for (std::string_view word : minus_words) {
+        key += '\0';
+        key += word;
+    }
+    return key;
+}
+
+bool QueryResultCache::Find(const std::string& key, uint64_t version, std::vector<Document>& result) {
+    Shard& shard = GetShard(key);
+    std::lock_guard lock(shard.mutex);
+
+    const auto it = shard.positions.find(key);
+    if (it == shard.positions.end()) {
+        ++shard.statistics.misses;
+        return false;
+    }
+    if (it->second->version != version) {
+        // Данные изменились: запись уже не пригодится.
+        shard.entries.erase(it->second);
+        shard.positions.erase(it);
+        ++shard.statistics.misses;
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    result = it->second->result;
+    ++shard.statistics.hits;
+    return true;
+}
+
+void QueryResultCache::Insert(std::string key, uint64_t version, std::vector<Document> result) {
+    Shard& shard = GetShard(key);
+    std::lock_guard lock(shard.mutex);
+
+    const auto it = shard.positions.find(key);
+    if (it != shard.positions.end()) {
+        // Тот же запрос посчитан параллельно; остаётся запись новой версии.
+        if (it->second->version <= version) {
+            it->second->version = version;
+            it->second->result = std::move(result);
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    if (shard.entries.size() >= shard_capacity_) {
+        shard.positions.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+    shard.entries.push_front(Entry{ std::move(key), version, std::move(result) });
+    shard.positions.emplace(shard.entries.front().key, shard.entries.begin());
+}
+
+QueryResultCache::Statistics QueryResultCache::GetStatistics() const {
+    Statistics result;
+    for (const Shard& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        result.hits += shard.statistics.hits;
+        result.misses += shard.statistics.misses;
+    }
+    return result;
+}
+
+QueryResultCache::Shard& QueryResultCache::GetShard(const std::string& key) {
+    return shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
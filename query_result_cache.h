@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+/**
+	* Кэш выдачи FindTopDocuments с вытеснением давно не запрошенных (LRU).
+	* Ключ - разобранный запрос, статус и размер выдачи; записи помечены версией
+	* данных сервера, и запись другой версии считается промахом. Кэш разбит на части со
+	* своими мьютексами, чтобы параллельные запросы реже ждали друг друга.
+	**/
+class QueryResultCache {
+public:
+    struct Statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    // capacity - общее число записей, делится между частями поровну.
+    explicit QueryResultCache(size_t capacity);
+
+    // Плюс- и минус-слова должны быть отсортированы и без повторов, как их
+    // возвращает разбор запроса, тогда одинаковые запросы дают один ключ.
+    static std::string MakeKey(const std::vector<std::string_view>& plus_words, const std::vector<std::string_view>& minus_words,
+        DocumentStatus status, size_t result_count);
+
+    // Копирует выдачу в result, если она есть и посчитана для version.
+    bool Find(const std::string& key, uint64_t version, std::vector<Document>& result);
+
+    void Insert(std::string key, uint64_t version, std::vector<Document> result);
+
+    Statistics GetStatistics() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry {
+        std::string key;
+        uint64_t version;
+        std::vector<Document> result;
+    };
+
+    // Начало списка - последняя запрошенная запись.
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> positions;    // ключи указывают в entries
+        Statistics statistics;
+    };
+
+    size_t shard_capacity_;
+    std::vector<Shard> shards_;
+
+    Shard& GetShard(const std::string& key);
+};
@@ -1,42 +1,31 @@
 #include "request_queue.h"
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
+    const auto start = RequestStatistics::Clock::now();
     auto result = search_server.FindTopDocuments(raw_query, status);
-    SetQueryRquest(result);
+    const auto finish = RequestStatistics::Clock::now();
+
+    AddLastRequest(!result.empty());
+    statistics_.AddRequest(finish, status, !result.empty(), finish - start);
     return result;
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
-    auto result = search_server.FindTopDocuments(raw_query);
-    SetQueryRquest(result);
-    return result;
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    auto count = requests_.back();
-    return count.empty_reqs;
+    return no_result_count_.load();
 }
 
-void RequestQueue::SetQueryRquest(const std::vector<Document>& req_item)
-{
-    QueryResult item;
-    item.number = requests_.empty() ? 1 : requests_.back().number+1;
-
-    if(requests_.size() >= min_in_day_){
-        requests_.pop_front();
-        if(requests_.front().empty_reqs && !req_item.empty()){
-            item.empty_reqs = requests_.back().empty_reqs-1;
-        }else{
-            item.empty_reqs = requests_.back().empty_reqs;
-        }
-    }else{
-        if(req_item.empty()){
-            item.empty_reqs = requests_.empty() ? 1 : requests_.back().empty_reqs+1;
-        }else{
-            item.empty_reqs = requests_.back().empty_reqs;
-        }
-    }
+RequestStatistics::Statistics RequestQueue::GetStatistics(RequestStatistics::Clock::duration window) const {
+    return statistics_.GetStatistics(RequestStatistics::Clock::now(), window);
+}
 
-      //  cout << item.number << "-" << item.empty_reqs << endl;
-    requests_.push_back(item);
+void RequestQueue::AddLastRequest(bool has_results)
+{
+    // Запрос вытесняет из кольца запрос, сделанный min_in_day_ запросов назад.
+    const uint64_t number = request_count_.fetch_add(1);
+    const bool evicted_no_result = no_result_flags_[number % min_in_day_].exchange(!has_results);
+    no_result_count_.fetch_add(static_cast<int>(!has_results) - static_cast<int>(evicted_no_result));
 }
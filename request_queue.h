@@ -1,11 +1,16 @@
 #pragma once
 
-#include <deque>
+#include <array>
+#include <atomic>
+#include <chrono>
 
+#include "request_statistics.h"
 #include "test_example_functions.h"
 
 /**
-	* Очередь запросов к поисковому серверу.
+	* Очередь запросов к поисковому серверу. Запросы можно добавлять из многих
+	* потоков: учёт последних запросов и статистика по времени ведутся на атомарных
+	* счётчиках без блокировок.
 	**/
 class RequestQueue {
 public:
@@ -23,25 +28,33 @@ public:
 
     std::vector<Document> AddFindRequest(const std::string& raw_query);
 
+    // Число запросов без результата среди последних min_in_day_.
     int GetNoResultRequests() const;
 
-private:
-    struct QueryResult {
-        int empty_reqs;
-        int number;
-    };
+    // Статистика запросов за последние window, не больше суток.
+    RequestStatistics::Statistics GetStatistics(RequestStatistics::Clock::duration window = std::chrono::hours(24)) const;
 
-    std::deque<QueryResult> requests_;
+private:
     const static int min_in_day_ = 1440;
     const SearchServer& search_server;
 
-    void SetQueryRquest(const std::vector<Document>& req_item);
+    // Кольцо из min_in_day_ последних запросов: true, если запрос без результата.
+    std::array<std::atomic<bool>, min_in_day_> no_result_flags_{};
+    std::atomic<uint64_t> request_count_{ 0 };
+    std::atomic<int> no_result_count_{ 0 };    // сумма флагов кольца
 
+    RequestStatistics statistics_;
+
+    void AddLastRequest(bool has_results);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
+    const auto start = RequestStatistics::Clock::now();
     auto result = search_server.FindTopDocuments(raw_query, document_predicate);
-    SetQueryRquest(result);
+    const auto finish = RequestStatistics::Clock::now();
+
+    AddLastRequest(!result.empty());
+    statistics_.AddRequest(finish, !result.empty(), finish - start);
     return result;
 }
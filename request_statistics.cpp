@@ -0,0 +1,106 @@
+#include "request_statistics.h"
+
+#include <algorithm>
+
+RequestStatistics::RequestStatistics()
+    : intervals_(INTERVAL_COUNT)
+{
+}
+
+void RequestStatistics::AddRequest(Clock::time_point time, DocumentStatus status, bool has_results, Clock::duration latency) {
+    AddRequest(time, static_cast<size_t>(status), has_results, latency);
+}
+
+void RequestStatistics::AddRequest(Clock::time_point time, bool has_results, Clock::duration latency) {
+    AddRequest(time, NO_STATUS, has_results, latency);
+}
+
+RequestStatistics::Statistics RequestStatistics::GetStatistics(Clock::time_point time, Clock::duration window) const {
+    Statistics result;
+    const int64_t last = GetIntervalNumber(time);
+    const int64_t count = std::clamp<int64_t>((window + INTERVAL_DURATION - Clock::duration(1)) / INTERVAL_DURATION,
+        1, INTERVAL_COUNT);
+
+    for (int64_t number = std::max<int64_t>(0, last - count + 1); number <= last; ++number) {
+        const Interval& interval = intervals_[number % INTERVAL_COUNT];
+        if (interval.number.load(std::memory_order_acquire) == number) {
+            AddCounts(interval, result);
+        }
+    }
+    return result;
+}
+
+void RequestStatistics::AddCounts(const Interval& interval, Statistics& statistics) {
+    statistics.request_count += interval.request_count.load(std::memory_order_relaxed);
+    statistics.no_result_count += interval.no_result_count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < STATUS_COUNT; ++i) {
+        statistics.status_counts[i] += interval.status_counts[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+        statistics.latency_histogram[i] += interval.latency_histogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+int64_t RequestStatistics::GetIntervalNumber(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::minutes>(time.time_since_epoch()) / INTERVAL_DURATION;
+}
+
+size_t RequestStatistics::GetLatencyBucket(Clock::duration latency) {
+    uint64_t microseconds = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    size_t bucket = 0;
+    while (microseconds != 0 && bucket + 1 < LATENCY_BUCKET_COUNT) {
+        microseconds >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+RequestStatistics::Interval* RequestStatistics::AcquireInterval(int64_t number) {
+    Interval& interval = intervals_[number % INTERVAL_COUNT];
+    int64_t current = interval.number.load(std::memory_order_acquire);
+    if (current > number) {
+        return nullptr;
+    }
+    // Ячейку переводит на новый интервал один поток, остальные сразу пишут в неё.
+    // Счётчики, прочитанные до перевода, вычитаются после него: запросы нового
+    // интервала пишутся только после перевода и не теряются, а запоздавшие
+    // запросы прошлого достаются новому.
+    while (current < number) {
+        if (interval.reset_number.load(std::memory_order_acquire) != current) {
+            // Перевод на current ещё вычитает счётчики, и прочитать их сейчас
+            // нельзя. Запрос не ждёт и достаётся интервалу current.
+            break;
+        }
+        Statistics previous;
+        AddCounts(interval, previous);
+        if (interval.number.compare_exchange_weak(current, number, std::memory_order_acq_rel)) {
+            interval.request_count.fetch_sub(previous.request_count, std::memory_order_relaxed);
+            interval.no_result_count.fetch_sub(previous.no_result_count, std::memory_order_relaxed);
+            for (size_t i = 0; i < STATUS_COUNT; ++i) {
+                interval.status_counts[i].fetch_sub(previous.status_counts[i], std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+                interval.latency_histogram[i].fetch_sub(previous.latency_histogram[i], std::memory_order_relaxed);
+            }
+            interval.reset_number.store(number, std::memory_order_release);
+            break;
+        }
+    }
+    return &interval;
+}
+
+void RequestStatistics::AddRequest(Clock::time_point time, size_t status, bool has_results, Clock::duration latency) {
+    Interval* interval = AcquireInterval(GetIntervalNumber(time));
+    if (interval == nullptr) {
+        // Запрос старше суток: его интервал уже вытеснен.
+        return;
+    }
+    interval->request_count.fetch_add(1, std::memory_order_relaxed);
+    if (!has_results) {
+        interval->no_result_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (status != NO_STATUS) {
+        interval->status_counts[status].fetch_add(1, std::memory_order_relaxed);
+    }
+    interval->latency_histogram[GetLatencyBucket(latency)].fetch_add(1, std::memory_order_relaxed);
+}
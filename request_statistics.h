@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "document.h"
+
+/**
+	* Статистика запросов за скользящее окно времени, которую пишут многие потоки
+	* без блокировок. Время разбито на минутные интервалы, их счётчики лежат в
+	* кольцевом буфере на сутки. Интервал, в который пишут впервые после полного
+	* оборота кольца, обнуляется тем потоком, который первым его займёт; запись
+	* никогда не ждёт. Запрос, записанный в ячейку во время её обнуления, может
+	* достаться соседнему интервалу. Чтение не останавливает запись, поэтому
+	* сумма за окно может не учесть запросы, записываемые в этот момент.
+	**/
+class RequestStatistics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::minutes INTERVAL_DURATION{ 1 };
+    static constexpr size_t INTERVAL_COUNT = 1440;
+    static constexpr size_t STATUS_COUNT = 4;    // значений DocumentStatus
+    // Интервал i гистограммы - задержки от 2^(i-1) до 2^i мкс, в нулевом - меньше микросекунды.
+    static constexpr size_t LATENCY_BUCKET_COUNT = 32;
+
+    struct Statistics {
+        uint64_t request_count = 0;
+        uint64_t no_result_count = 0;
+        std::array<uint64_t, STATUS_COUNT> status_counts{};    // индекс - DocumentStatus
+        std::array<uint64_t, LATENCY_BUCKET_COUNT> latency_histogram{};
+    };
+
+    RequestStatistics();
+
+    void AddRequest(Clock::time_point time, DocumentStatus status, bool has_results, Clock::duration latency);
+
+    // Запрос с предикатом вместо статуса учитывается без статуса.
+    void AddRequest(Clock::time_point time, bool has_results, Clock::duration latency);
+
+    // Статистика за window до time, не больше суток.
+    Statistics GetStatistics(Clock::time_point time, Clock::duration window) const;
+
+private:
+    static constexpr int64_t UNUSED = -1;
+    static constexpr size_t NO_STATUS = STATUS_COUNT;
+
+    struct alignas(64) Interval {
+        std::atomic<int64_t> number{ UNUSED };          // номер интервала от начала отсчёта часов
+        std::atomic<int64_t> reset_number{ UNUSED };    // интервал, для которого обнуление закончено
+        std::atomic<uint64_t> request_count{ 0 };
+        std::atomic<uint64_t> no_result_count{ 0 };
+        std::array<std::atomic<uint64_t>, STATUS_COUNT> status_counts{};
+        std::array<std::atomic<uint64_t>, LATENCY_BUCKET_COUNT> latency_histogram{};
+    };
+
+    std::vector<Interval> intervals_;    // INTERVAL_COUNT ячеек, в куче: это сотни килобайт
+
+    static int64_t GetIntervalNumber(Clock::time_point time);
+
+    static size_t GetLatencyBucket(Clock::duration latency);
+
+    static void AddCounts(const Interval& interval, Statistics& statistics);
+
+    // Ячейка интервала number, обнулённая, если раньше в ней был более ранний.
+    // nullptr, если ячейку уже занял более поздний интервал. Не ждёт других потоков.
+    Interval* AcquireInterval(int64_t number);
+
+    void AddRequest(Clock::time_point time, size_t status, bool has_results, Clock::duration latency);
+};
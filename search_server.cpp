@@ -1,7 +1,10 @@
 #include <algorithm>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
 #include "search_server.h"
-#include "log_duration.h" // Профилировщик. Нужен был для отладки.
 
 using namespace std::string_literals;
 
@@ -14,23 +17,312 @@ SearchServer::SearchServer(std::string_view stop_words_text)
 {}
 
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    ScopedStageTimer timer(ProfileStage::ADD_DOCUMENT);
+    CheckWritable();
+    if ((document_id < 0) || (FindOrdinal(document_id) != NO_ORDINAL)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
 
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, document.data() });
-    document_ids_.insert(document_id);
+    // Термы копируются в арену словарём, поэтому текст можно разбирать до его сохранения.
+    const auto words = SplitIntoWordsNoStop(document);
+
+    const uint32_t ordinal = static_cast<uint32_t>(documents_.ids.size());
+    documents_.ids.push_back(document_id);
+    documents_.ratings.push_back(ComputeAverageRating(ratings));
+    documents_.statuses.push_back(status);
+    documents_.texts.push_back(text_arena_.Append(document));
+    removed_bits_.resize((documents_.ids.size() + 63) / 64);
+    InsertSortedId(document_id, ordinal);
 
-    const auto words = SplitIntoWordsNoStop(documents_.at(document_id).str);
     const double inv_word_count = 1.0 / words.size();
+
+    std::map<uint32_t, double> term_freqs;
     for (std::string_view word : words) {
-        document_to_word_freqs_[document_id][word] += inv_word_count;
-        word_to_document_freqs_[word][document_id] += inv_word_count;
+        term_freqs[dictionary_.Intern(word, text_arena_)] += inv_word_count;
+    }
+
+    if (postings_.size() < dictionary_.size()) {
+        postings_.resize(dictionary_.size());
+    }
+    while (term_statistics_.size() < dictionary_.size()) {
+        term_statistics_.emplace_back();
+    }
+    ++index_version_;
+    ++result_cache_version_;
+
+    auto& document_terms = document_terms_.emplace_back();
+    document_terms.reserve(term_freqs.size());
+    for (const auto [term_id, term_freq] : term_freqs) {
+        document_terms.push_back(TermFrequency{ term_id, term_freq });
+
+        // Порядковые номера только растут, поэтому списки остаются отсортированными.
+        postings_[term_id].push_back(Posting{ ordinal, term_freq });
+        auto& statistics = term_statistics_[term_id];
+        statistics.max_term_freq = std::max(statistics.max_term_freq, term_freq);
+        ++statistics.document_freq;
     }
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(std::execution::seq, raw_query, status);
+void SearchServer::BuildPartialIndex(const std::vector<DocumentInput>& documents, uint32_t first_ordinal, PartialIndex& partial) const {
+    // Последний документ, где встретился локальный терм, и позиция терма в его списке:
+    // TF копится так же, как в AddDocument, но без поиска по дереву.
+    std::vector<size_t> term_documents;
+    std::vector<uint32_t> term_positions;
+
+    partial.document_terms.reserve(partial.last_document - partial.first_document);
+    for (size_t i = partial.first_document; i < partial.last_document; ++i) {
+        std::vector<std::string_view> words;
+        try {
+            words = SplitIntoWordsNoStop(documents[i].text);
+        }
+        catch (const std::invalid_argument& e) {
+            partial.error_document = i;
+            partial.error = e.what();
+            return;
+        }
+
+        const double inv_word_count = 1.0 / words.size();
+        auto& document_terms = partial.document_terms.emplace_back();
+        for (std::string_view word : words) {
+            const auto [it, inserted] = partial.term_ids.emplace(word, static_cast<uint32_t>(partial.terms.size()));
+            if (inserted) {
+                partial.terms.push_back(word);
+                partial.postings.emplace_back();
+                term_documents.push_back(i);
+                term_positions.push_back(static_cast<uint32_t>(document_terms.size()));
+                document_terms.push_back(TermFrequency{ it->second, 0.0 });
+            }
+            else if (term_documents[it->second] != i) {
+                term_documents[it->second] = i;
+                term_positions[it->second] = static_cast<uint32_t>(document_terms.size());
+                document_terms.push_back(TermFrequency{ it->second, 0.0 });
+            }
+            document_terms[term_positions[it->second]].term_freq += inv_word_count;
+        }
+
+        const uint32_t ordinal = first_ordinal + static_cast<uint32_t>(i);
+        for (const TermFrequency& item : document_terms) {
+            partial.postings[item.term_id].push_back(Posting{ ordinal, item.term_freq });
+        }
+    }
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocumentBatch(ExecutionPolicy&& policy, const std::vector<DocumentInput>& documents) {
+    ScopedStageTimer timer(ProfileStage::ADD_DOCUMENT);
+    CheckWritable();
+
+    std::vector<std::pair<int, uint32_t>> added_ids;
+    added_ids.reserve(documents.size());
+    const uint32_t first_ordinal = static_cast<uint32_t>(documents_.ids.size());
+    for (uint32_t i = 0; i < documents.size(); ++i) {
+        if ((documents[i].id < 0) || (FindOrdinal(documents[i].id) != NO_ORDINAL)) {
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+        added_ids.emplace_back(documents[i].id, first_ordinal + i);
+    }
+    std::sort(added_ids.begin(), added_ids.end());
+    if (std::adjacent_find(added_ids.begin(), added_ids.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first == rhs.first;
+        }) != added_ids.end()) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+
+    // Последовательно пакет разбирается одним частичным индексом.
+    size_t part_size = std::max<size_t>(documents.size(), 1);
+    if constexpr (!std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        const size_t part_count = std::max(1u, std::thread::hardware_concurrency()) * 4;
+        part_size = std::max(MIN_BATCH_PART_SIZE, (documents.size() + part_count - 1) / part_count);
+    }
+    std::vector<PartialIndex> partials((documents.size() + part_size - 1) / part_size);
+    for (size_t part = 0; part < partials.size(); ++part) {
+        partials[part].first_document = part * part_size;
+        partials[part].last_document = std::min(documents.size(), (part + 1) * part_size);
+    }
+
+    std::for_each(policy, partials.begin(), partials.end(), [&](PartialIndex& partial) {
+        BuildPartialIndex(documents, first_ordinal, partial);
+        });
+    for (const auto& partial : partials) {
+        if (partial.error_document != std::numeric_limits<size_t>::max()) {
+            throw std::invalid_argument(partial.error);
+        }
+    }
+
+    for (const auto& document : documents) {
+        documents_.ids.push_back(document.id);
+        documents_.ratings.push_back(ComputeAverageRating(document.ratings));
+        documents_.statuses.push_back(document.status);
+        documents_.texts.push_back(text_arena_.Append(document.text));
+    }
+    removed_bits_.resize((documents_.ids.size() + 63) / 64);
+
+    // Термы частей регистрируются по порядку частей, поэтому идентификаторы
+    // выдаются в том же порядке, что и при добавлении по одному документу.
+    struct TermSource {
+        uint32_t term_id;
+        uint32_t part;
+        uint32_t local_id;
+    };
+    std::vector<TermSource> term_sources;
+    for (uint32_t part = 0; part < partials.size(); ++part) {
+        auto& partial = partials[part];
+        partial.global_term_ids.reserve(partial.terms.size());
+        for (uint32_t local_id = 0; local_id < partial.terms.size(); ++local_id) {
+            const uint32_t term_id = dictionary_.Intern(partial.terms[local_id], text_arena_);
+            partial.global_term_ids.push_back(term_id);
+            term_sources.push_back({ term_id, part, local_id });
+        }
+    }
+
+    if (postings_.size() < dictionary_.size()) {
+        postings_.resize(dictionary_.size());
+    }
+    while (term_statistics_.size() < dictionary_.size()) {
+        term_statistics_.emplace_back();
+    }
+    ++index_version_;
+    ++result_cache_version_;
+
+    // Слияние сортировкой: части одного терма оказываются рядом в порядке частей,
+    // а номера документов части больше номеров предыдущих, так что список терма
+    // собирается дописыванием. Разные термы сливаются независимо.
+    std::stable_sort(policy, term_sources.begin(), term_sources.end(), [](const TermSource& lhs, const TermSource& rhs) {
+        return lhs.term_id < rhs.term_id;
+        });
+    std::vector<std::pair<size_t, size_t>> term_groups;
+    for (size_t i = 0; i < term_sources.size(); ++i) {
+        if (i == 0 || term_sources[i].term_id != term_sources[i - 1].term_id) {
+            term_groups.emplace_back(i, i);
+        }
+        term_groups.back().second = i + 1;
+    }
+
+    std::for_each(policy, term_groups.begin(), term_groups.end(), [&](const std::pair<size_t, size_t>& group) {
+        const auto [group_begin, group_end] = group;
+        auto& postings = postings_[term_sources[group_begin].term_id];
+        auto& statistics = term_statistics_[term_sources[group_begin].term_id];
+
+        size_t posting_count = postings.size();
+        for (size_t i = group_begin; i < group_end; ++i) {
+            posting_count += partials[term_sources[i].part].postings[term_sources[i].local_id].size();
+        }
+        statistics.document_freq += static_cast<uint32_t>(posting_count - postings.size());
+        postings.reserve(posting_count);
+        for (size_t i = group_begin; i < group_end; ++i) {
+            for (const Posting& posting : partials[term_sources[i].part].postings[term_sources[i].local_id]) {
+                postings.push_back(posting);
+                statistics.max_term_freq = std::max(statistics.max_term_freq, posting.term_freq);
+            }
+        }
+        });
+
+    document_terms_.resize(first_ordinal + documents.size());
+    std::for_each(policy, partials.begin(), partials.end(), [&](PartialIndex& partial) {
+        for (size_t i = partial.first_document; i < partial.last_document; ++i) {
+            auto& document_terms = partial.document_terms[i - partial.first_document];
+            for (auto& item : document_terms) {
+                item.term_id = partial.global_term_ids[item.term_id];
+            }
+            std::sort(document_terms.begin(), document_terms.end(), [](const TermFrequency& lhs, const TermFrequency& rhs) {
+                return lhs.term_id < rhs.term_id;
+                });
+            document_terms_[first_ordinal + i] = std::move(document_terms);
+        }
+        });
+
+    MergeSortedIds(std::move(added_ids));
+}
+
+void SearchServer::InsertSortedId(int document_id, uint32_t ordinal) {
+    if (sorted_ids_.empty() || sorted_ids_.back() < document_id) {
+        sorted_ids_.push_back(document_id);
+        sorted_ordinals_.push_back(ordinal);
+        return;
+    }
+
+    const auto it = std::lower_bound(sorted_ids_.begin(), sorted_ids_.end(), document_id);
+    if (*it == document_id) {
+        // Удалённый документ ещё в списке: новый занимает его место.
+        sorted_ordinals_[it - sorted_ids_.begin()] = ordinal;
+        --removed_id_count_;
+        return;
+    }
+
+    const size_t position = std::lower_bound(inserted_ids_.begin(), inserted_ids_.end(), document_id) - inserted_ids_.begin();
+    inserted_ids_.insert(inserted_ids_.begin() + position, document_id);
+    inserted_ordinals_.insert(inserted_ordinals_.begin() + position, ordinal);
+    if (inserted_ids_.size() >= std::max(MIN_MERGED_INSERT_COUNT, sorted_ids_.size() / 64)) {
+        MergeSortedIds({});
+    }
+}
+
+void SearchServer::MergeSortedIds(std::vector<std::pair<int, uint32_t>> ids) {
+    size_t kept = 0;
+    for (const auto& [document_id, ordinal] : ids) {
+        const auto it = std::lower_bound(sorted_ids_.begin(), sorted_ids_.end(), document_id);
+        if (it != sorted_ids_.end() && *it == document_id) {
+            sorted_ordinals_[it - sorted_ids_.begin()] = ordinal;
+            --removed_id_count_;
+        }
+        else {
+            ids[kept++] = { document_id, ordinal };
+        }
+    }
+    ids.resize(kept);
+
+    for (size_t i = 0; i < inserted_ids_.size(); ++i) {
+        ids.emplace_back(inserted_ids_[i], inserted_ordinals_[i]);
+    }
+    std::inplace_merge(ids.begin(), ids.begin() + kept, ids.end());
+    inserted_ids_.clear();
+    inserted_ordinals_.clear();
+    if (ids.empty()) {
+        return;
+    }
+
+    // Обычно идентификаторы больше имеющихся, иначе списки сливаются.
+    if (!sorted_ids_.empty() && ids.front().first < sorted_ids_.back()) {
+        std::vector<int> sorted_ids;
+        std::vector<uint32_t> sorted_ordinals;
+        sorted_ids.reserve(sorted_ids_.size() + ids.size());
+        sorted_ordinals.reserve(sorted_ids_.size() + ids.size());
+        size_t i = 0;
+        for (const auto& [document_id, ordinal] : ids) {
+            for (; i < sorted_ids_.size() && sorted_ids_[i] < document_id; ++i) {
+                sorted_ids.push_back(sorted_ids_[i]);
+                sorted_ordinals.push_back(sorted_ordinals_[i]);
+            }
+            sorted_ids.push_back(document_id);
+            sorted_ordinals.push_back(ordinal);
+        }
+        sorted_ids.insert(sorted_ids.end(), sorted_ids_.begin() + i, sorted_ids_.end());
+        sorted_ordinals.insert(sorted_ordinals.end(), sorted_ordinals_.begin() + i, sorted_ordinals_.end());
+        sorted_ids_ = std::move(sorted_ids);
+        sorted_ordinals_ = std::move(sorted_ordinals);
+    }
+    else {
+        for (const auto& [document_id, ordinal] : ids) {
+            sorted_ids_.push_back(document_id);
+            sorted_ordinals_.push_back(ordinal);
+        }
+    }
+}
+
+void SearchServer::AddDocuments(const std::vector<DocumentInput>& documents) {
+    AddDocumentBatch(std::execution::seq, documents);
+}
+
+void SearchServer::AddDocuments(std::execution::sequenced_policy seq, const std::vector<DocumentInput>& documents) {
+    AddDocumentBatch(seq, documents);
+}
+
+void SearchServer::AddDocuments(std::execution::parallel_policy par, const std::vector<DocumentInput>& documents) {
+    AddDocumentBatch(par, documents);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, result_count);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
@@ -38,53 +330,310 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query)
 }
 
 size_t SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return mapped_.snapshot ? mapped_.document_count : sorted_ids_.size() - removed_id_count_ + inserted_ids_.size();
+}
+
+void SearchServer::EnableResultCache(size_t capacity) {
+    result_cache_ = capacity > 0 ? std::make_unique<QueryResultCache>(capacity) : nullptr;
+}
+
+QueryResultCache::Statistics SearchServer::GetResultCacheStatistics() const {
+    return result_cache_ ? result_cache_->GetStatistics() : QueryResultCache::Statistics{};
+}
+
+void SearchServer::AddCorpusStatistics(std::string_view raw_query, CorpusStatistics& statistics) const {
+    const auto query = ParseQuery(raw_query);
+
+    statistics.document_count += GetDocumentCount();
+    for (std::string_view word : query.plus_words) {
+        const uint32_t term_id = dictionary_.Find(word);
+        statistics.document_freqs[word] += term_id == TermDictionary::NO_TERM ? 0 : GetDocumentFreq(term_id);
+    }
+}
+
+std::vector<SearchServer::DocumentInput> SearchServer::ExportDocuments() const {
+    if (mapped_.snapshot) {
+        throw std::logic_error("Snapshot doesn't keep document texts"s);
+    }
+
+    std::vector<DocumentInput> documents;
+    documents.reserve(GetDocumentCount());
+    for (auto it = begin(), last = end(); it != last; ++it) {
+        const uint32_t ordinal = it.GetOrdinal();
+        documents.push_back({ *it, text_arena_.Get(documents_.texts[ordinal]), documents_.statuses[ordinal],
+            { documents_.ratings[ordinal] } });
+    }
+    return documents;
 }
 
 std::map<int, std::map<std::string_view, double>> SearchServer::GetDocumentWordsFreqs() {
-    return document_to_word_freqs_;
+    std::map<int, std::map<std::string_view, double>> result;
+    for (const int document_id : *this) {
+        result.emplace(document_id, GetWordFrequencies(document_id));
+    }
+    return result;
 }
 
-template <typename ExecutionPolicy>
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const
-{
-    if (!document_ids_.count(document_id)) {
-        throw std::out_of_range("incorrect document id"s);
+SearchServer::DocumentIdIterator SearchServer::begin() const {
+    DocumentIdIterator result = MakeDocumentIdIterator();
+    result.SkipRemoved();
+    return result;
+}
+
+SearchServer::DocumentIdIterator SearchServer::end() const {
+    DocumentIdIterator result = MakeDocumentIdIterator();
+    result.sorted_ordinals_ += result.sorted_end_ - result.sorted_ids_;
+    result.sorted_ids_ = result.sorted_end_;
+    result.inserted_ordinals_ += result.inserted_end_ - result.inserted_ids_;
+    result.inserted_ids_ = result.inserted_end_;
+    return result;
+}
+
+bool SearchServer::ContainsDocument(int document_id) const {
+    return FindOrdinal(document_id) != NO_ORDINAL;
+}
+
+SearchServer::DocumentIdIterator SearchServer::MakeDocumentIdIterator() const {
+    const auto ids = GetSortedIds();
+    DocumentIdIterator result;
+    result.sorted_ids_ = ids.begin();
+    result.sorted_end_ = ids.end();
+    result.sorted_ordinals_ = mapped_.snapshot ? mapped_.sorted_ordinals : sorted_ordinals_.data();
+    result.inserted_ids_ = inserted_ids_.data();
+    result.inserted_end_ = inserted_ids_.data() + inserted_ids_.size();
+    result.inserted_ordinals_ = inserted_ordinals_.data();
+    result.removed_bits_ = removed_id_count_ > 0 ? removed_bits_.data() : nullptr;
+    return result;
+}
+
+bool SearchServer::IsReadOnly() const {
+    return mapped_.snapshot != nullptr;
+}
+
+void SearchServer::CheckWritable() const {
+    if (IsReadOnly()) {
+        throw std::logic_error("Index snapshot is read-only"s);
     }
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    return MatchDocument(std::execution::seq, raw_query, document_id);
+}
 
-    const auto query = ParseQuery(policy, raw_query);
+SearchServer::PreparedQuery SearchServer::PrepareQuery(std::string_view raw_query) const {
+    PreparedQuery result = PrepareSearchQuery(raw_query);
+    result.match_plan_ = PlanMatch(result.query_);
+    return result;
+}
 
-    std::vector<std::string_view> matched_words(query.plus_words.size());
-    auto status = documents_.at(document_id).status;
+SearchServer::PreparedQuery SearchServer::PrepareSearchQuery(std::string_view raw_query) const {
+    PreparedQuery result;
+    result.text_ = std::make_unique<const std::string>(raw_query);
+    result.query_ = ParseQuery(*result.text_);
+    result.server_id_ = instance_id_.Get();
+    result.index_version_ = index_version_;
+    result.resolved_ = ResolveQuery(result.query_, nullptr);
+    return result;
+}
 
-    const auto pred = [this, document_id](std::string_view word) {
-        const auto it = word_to_document_freqs_.find(word);
-        return it != word_to_document_freqs_.end() && it->second.count(document_id);
-    };
+size_t SearchServer::GetPostingCount(const PreparedQuery& query) const {
+    return IsResolutionCurrent(query) ? CountPostings(query.resolved_) : CountPostings(ResolveQuery(query.query_, nullptr));
+}
+
+size_t SearchServer::CountPostings(const ResolvedQuery& query) {
+    size_t posting_count = 0;
+    for (const auto& term : query.plus_terms) {
+        posting_count += term.postings.size;
+    }
+    for (const PostingList& postings : query.minus_postings) {
+        posting_count += postings.size;
+    }
+    return posting_count;
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentStatus status, size_t result_count) const {
+    return FindTopDocuments(std::execution::seq, query, status, result_count);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const PreparedQuery& query, int document_id) const {
+    return MatchDocument(std::execution::seq, query, document_id);
+}
+
+std::vector<SearchServer::MatchResult> SearchServer::MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const {
+    return MatchDocuments(std::execution::seq, raw_query, document_ids);
+}
+
+std::vector<SearchServer::MatchResult> SearchServer::MatchDocuments(const PreparedQuery& query, const std::vector<int>& document_ids) const {
+    return MatchDocuments(std::execution::seq, query, document_ids);
+}
+
+SearchServer::MatchPlan SearchServer::PlanMatch(const Query& query) const {
+    MatchPlan plan;
+    for (uint32_t i = 0; i < query.plus_words.size(); ++i) {
+        const uint32_t term_id = dictionary_.Find(query.plus_words[i]);
+        if (term_id != TermDictionary::NO_TERM) {
+            plan.plus_terms.emplace_back(term_id, i);
+        }
+    }
+    for (std::string_view word : query.minus_words) {
+        const uint32_t term_id = dictionary_.Find(word);
+        if (term_id != TermDictionary::NO_TERM) {
+            plan.minus_term_ids.push_back(term_id);
+        }
+    }
+    std::sort(plan.plus_terms.begin(), plan.plus_terms.end());
+    std::sort(plan.minus_term_ids.begin(), plan.minus_term_ids.end());
 
-    if (std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), pred)) {
+    plan.word_indices.reserve(plan.plus_terms.size() + plan.minus_term_ids.size());
+    for (const auto& [term_id, word_index] : plan.plus_terms) {
+        plan.word_indices.emplace(term_id, word_index);
+    }
+    // Минус-слово исключает документ, даже если оно же есть среди плюс-слов.
+    for (const uint32_t term_id : plan.minus_term_ids) {
+        plan.word_indices[term_id] = MINUS_WORD;
+    }
+    return plan;
+}
+
+SearchServer::MatchResult SearchServer::MatchOrdinal(const Query& query, const MatchPlan& plan, uint32_t ordinal, bool parallel) const {
+    const DocumentStatus status = GetDocumentColumns().statuses[ordinal];
+    std::vector<uint32_t> matched_words;
+    if (!mapped_.snapshot) {
+        const auto& terms = document_terms_[ordinal];
+        matched_words = MatchTermRange(plan, terms.data(), terms.data() + terms.size(), parallel);
+    }
+    else {
+        const uint64_t first = mapped_.document_term_offsets[ordinal];
+        const uint64_t last = mapped_.document_term_offsets[ordinal + 1];
+        matched_words = mapped_.compressed
+            ? MatchTermRange(plan, mapped_.document_term_ids + first, mapped_.document_term_ids + last, parallel)
+            : MatchTermRange(plan, mapped_.document_terms + first, mapped_.document_terms + last, parallel);
+    }
+    if (matched_words.empty()) {
         return { std::vector<std::string_view>{}, status };
     }
 
-    auto it = std::copy_if(policy, query.plus_words.begin(), query.plus_words.end(),
-        matched_words.begin(),
-        pred
-    );
+    // Слова выдаются в порядке запроса, как в MatchDocument.
+    std::sort(matched_words.begin(), matched_words.end());
+    std::vector<std::string_view> words;
+    words.reserve(matched_words.size());
+    for (const uint32_t word_index : matched_words) {
+        words.push_back(query.plus_words[word_index]);
+    }
+    return { words, status };
+}
+
+uint32_t SearchServer::GetTermId(const TermFrequency& item) {
+    return item.term_id;
+}
+
+uint32_t SearchServer::GetTermId(uint32_t term_id) {
+    return term_id;
+}
+
+template <typename TermIterator>
+std::vector<uint32_t> SearchServer::MatchTermRange(const MatchPlan& plan, TermIterator first, TermIterator last, bool parallel) {
+    const auto is_before = [](const auto& item, uint32_t term_id) {
+        return GetTermId(item) < term_id;
+    };
 
-    if constexpr (!std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
-        matched_words.erase(it, matched_words.end());
-        return { matched_words, status };
+    std::vector<uint32_t> matched_words;
+    const size_t range_size = last - first;
+    const size_t term_count = plan.plus_terms.size() + plan.minus_term_ids.size();
+    const size_t search_work = term_count * static_cast<size_t>(std::log2(range_size + 1) + 1);
+    const bool hashed = range_size * HASHED_LOOKUP_COST <= search_work;
+    const size_t work = hashed ? range_size * HASHED_LOOKUP_COST : search_work;
+    parallel = parallel && work >= MIN_PARALLEL_MATCH_WORK && std::thread::hardware_concurrency() > 1;
+
+    if (hashed) {
+        // Ищет термы [begin, end) в таблице запроса; false, если нашлось минус-слово.
+        const auto match_terms = [&plan](TermIterator begin, TermIterator end, std::vector<uint32_t>& words) {
+            for (; begin != end; ++begin) {
+                const auto it = plan.word_indices.find(GetTermId(*begin));
+                if (it == plan.word_indices.end()) {
+                    continue;
+                }
+                if (it->second == MINUS_WORD) {
+                    return false;
+                }
+                words.push_back(it->second);
+            }
+            return true;
+        };
+        if (!parallel) {
+            return match_terms(first, last, matched_words) ? matched_words : std::vector<uint32_t>{};
+        }
+
+        const size_t chunk_count = (range_size + MATCH_CHUNK_SIZE - 1) / MATCH_CHUNK_SIZE;
+        std::vector<std::vector<uint32_t>> chunk_words(chunk_count);
+        std::vector<size_t> chunks(chunk_count);
+        std::iota(chunks.begin(), chunks.end(), size_t{ 0 });
+        std::atomic<bool> has_minus_word{ false };
+        std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](size_t chunk) {
+            const size_t begin = chunk * MATCH_CHUNK_SIZE;
+            const size_t end = std::min(begin + MATCH_CHUNK_SIZE, range_size);
+            if (!has_minus_word.load(std::memory_order_relaxed) && !match_terms(first + begin, first + end, chunk_words[chunk])) {
+                has_minus_word.store(true, std::memory_order_relaxed);
+            }
+            });
+        if (has_minus_word.load()) {
+            return {};
+        }
+        for (const auto& words : chunk_words) {
+            matched_words.insert(matched_words.end(), words.begin(), words.end());
+        }
+        return matched_words;
+    }
+
+    if (parallel) {
+        // Термы проверяются независимо: бинарный поиск каждого в прямом индексе.
+        const auto contains = [&](uint32_t term_id) {
+            const auto it = std::lower_bound(first, last, term_id, is_before);
+            return it != last && GetTermId(*it) == term_id;
+        };
+        if (std::any_of(std::execution::par, plan.minus_term_ids.begin(), plan.minus_term_ids.end(), contains)) {
+            return {};
+        }
+        std::vector<char> matched(plan.plus_terms.size());
+        std::transform(std::execution::par, plan.plus_terms.begin(), plan.plus_terms.end(), matched.begin(),
+            [&](const std::pair<uint32_t, uint32_t>& term) {
+                return contains(term.first);
+            });
+        for (size_t i = 0; i < matched.size(); ++i) {
+            if (matched[i]) {
+                matched_words.push_back(plan.plus_terms[i].second);
+            }
+        }
+        return matched_words;
     }
 
-    std::sort(policy, matched_words.begin(), it);
-    auto last = std::unique(policy, matched_words.begin(), it);
-    matched_words.erase(last, matched_words.end());
+    // Оба списка отсортированы: поиск следующего терма продолжается с места предыдущего.
+    TermIterator term = first;
+    for (const uint32_t minus_term_id : plan.minus_term_ids) {
+        term = std::lower_bound(term, last, minus_term_id, is_before);
+        if (term == last) {
+            break;
+        }
+        if (GetTermId(*term) == minus_term_id) {
+            return {};
+        }
+    }
 
-    return { matched_words, status };
+    term = first;
+    for (const auto& [plus_term_id, word_index] : plan.plus_terms) {
+        term = std::lower_bound(term, last, plus_term_id, is_before);
+        if (term == last) {
+            break;
+        }
+        if (GetTermId(*term) == plus_term_id) {
+            matched_words.push_back(word_index);
+        }
+    }
+    return matched_words;
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
-    return MatchDocument(std::execution::seq, raw_query, document_id);
+bool SearchServer::IsResolutionCurrent(const PreparedQuery& query) const {
+    return query.server_id_ == instance_id_.Get() && query.index_version_ == index_version_;
 }
 
 bool SearchServer::IsStopWord(std::string_view word) const {
@@ -100,14 +649,14 @@ bool SearchServer::IsValidWord(std::string_view word) {
 
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
     std::vector<std::string_view> words;
-    for (std::string_view word : SplitIntoWordsView(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word "s + word.data() + " is invalid"s);
-        }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+    std::string_view invalid_word;
+    // Проверка на управляющие символы идёт в том же проходе, что и разбиение.
+    if (!SplitIntoValidWordsView(text, words, invalid_word)) {
+        throw std::invalid_argument("Word "s + std::string(invalid_word) + " is invalid"s);
     }
+    words.erase(std::remove_if(words.begin(), words.end(), [this](std::string_view word) {
+        return IsStopWord(word);
+        }), words.end());
     return words;
 }
 
@@ -128,8 +677,9 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
         is_minus = true;
         text = text.substr(1);
     }
-    if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
-        throw std::invalid_argument("Query word "s + text.data() + " is invalid");
+    // Управляющие символы уже отсеяны в SplitIntoQueryWords.
+    if (text.empty() || text[0] == '-') {
+        throw std::invalid_argument("Query word "s + std::string(text) + " is invalid"s);
     }
 
     return { text, is_minus, IsStopWord(text) };
@@ -155,8 +705,21 @@ SearchServer::Query SearchServer::PushPlusMinusWords(const std::vector<std::stri
     return result;
 }
 
+std::vector<std::string_view> SearchServer::SplitIntoQueryWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    std::string_view invalid_word;
+    if (!SplitIntoValidWordsView(text, words, invalid_word)) {
+        if (invalid_word[0] == '-') {
+            invalid_word.remove_prefix(1);
+        }
+        throw std::invalid_argument("Query word "s + std::string(invalid_word) + " is invalid"s);
+    }
+    return words;
+}
+
 SearchServer::Query SearchServer::ParseQuery(std::execution::sequenced_policy seq, std::string_view text) const {
-    std::vector<std::string_view> words = SplitIntoWordsView(text);
+    ScopedStageTimer timer(ProfileStage::PARSE);
+    std::vector<std::string_view> words = SplitIntoQueryWords(text);
 
     std::sort(seq, words.begin(), words.end());
     auto last = std::unique(seq, words.begin(), words.end());
@@ -166,7 +729,17 @@ SearchServer::Query SearchServer::ParseQuery(std::execution::sequenced_policy se
 }
 
 SearchServer::Query SearchServer::ParseQuery(std::execution::parallel_policy par, std::string_view text) const {
-    std::vector<std::string_view> words = SplitIntoWordsView(text);
+    ScopedStageTimer timer(ProfileStage::PARSE);
+    std::vector<std::string_view> words = SplitIntoQueryWords(text);
+    // Сортировка короткого запроса не окупает запуск задач.
+    if (words.size() < MIN_PARALLEL_QUERY_WORD_COUNT) {
+        std::sort(words.begin(), words.end());
+    }
+    else {
+        std::sort(par, words.begin(), words.end());
+    }
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
     return PushPlusMinusWords(words);
 }
 
@@ -174,79 +747,709 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
     return ParseQuery(std::execution::seq, text);
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+double SearchServer::ComputeWordInverseDocumentFreq(uint32_t term_id) const {
+    return log(GetDocumentCount() * 1.0 / GetDocumentFreq(term_id));
+}
+
+double SearchServer::GetInverseDocumentFreq(uint32_t term_id) const {
+    if (mapped_.snapshot) {
+        return mapped_.inverse_document_freqs[term_id];
+    }
+
+    TermStatistics& statistics = term_statistics_[term_id];
+    if (statistics.version.load(std::memory_order_acquire) == index_version_) {
+        return statistics.inverse_document_freq.load(std::memory_order_relaxed);
+    }
+
+    const double inverse_document_freq = ComputeWordInverseDocumentFreq(term_id);
+    statistics.inverse_document_freq.store(inverse_document_freq, std::memory_order_relaxed);
+    statistics.version.store(index_version_, std::memory_order_release);
+    return inverse_document_freq;
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
+SearchServer::PostingList SearchServer::GetTermPostings(uint32_t term_id) const {
+    PostingList result;
+    if (!mapped_.snapshot) {
+        const auto& postings = postings_[term_id];
+        result.first = postings.data();
+        result.last = postings.data() + postings.size();
+        result.size = postings.size();
+        return result;
+    }
+
+    result.size = mapped_.posting_offsets[term_id + 1] - mapped_.posting_offsets[term_id];
+    if (mapped_.compressed) {
+        result.blocks = mapped_.posting_blocks + mapped_.posting_block_offsets[term_id];
+        result.block_count = mapped_.posting_block_offsets[term_id + 1] - mapped_.posting_block_offsets[term_id];
+    }
+    else {
+        result.first = mapped_.postings + mapped_.posting_offsets[term_id];
+        result.last = result.first + result.size;
+    }
+    return result;
+}
 
-    static std::map<std::string_view, double> dummy;
+double SearchServer::GetMaxTermFreq(uint32_t term_id) const {
+    return mapped_.snapshot ? mapped_.max_term_freqs[term_id] : term_statistics_[term_id].max_term_freq;
+}
 
-    if (!document_to_word_freqs_.count(document_id)) {
-        return dummy;
+size_t SearchServer::GetDocumentFreq(uint32_t term_id) const {
+    if (mapped_.snapshot) {
+        // В снимок попадают только живые документы.
+        return mapped_.posting_offsets[term_id + 1] - mapped_.posting_offsets[term_id];
     }
+    return term_statistics_[term_id].document_freq;
+}
 
-    return document_to_word_freqs_.at(document_id);
+SearchServer::DocumentColumnsView SearchServer::GetDocumentColumns() const {
+    if (mapped_.snapshot) {
+        return mapped_.documents;
+    }
+    return { documents_.ids.data(), documents_.ratings.data(), documents_.statuses.data(),
+        static_cast<uint32_t>(documents_.ids.size()) };
 }
 
-void SearchServer::RemoveDocument(int document_id) {
-    //LOG_DURATION_STREAM("remove documents", std::cout);
+std::vector<SearchServer::TermFrequency> SearchServer::GetDocumentTerms(uint32_t ordinal) const {
+    if (!mapped_.snapshot) {
+        return document_terms_[ordinal];
+    }
 
-    if (GetWordFrequencies(document_id).empty()) {
-        return;
+    const uint64_t first = mapped_.document_term_offsets[ordinal];
+    const uint64_t last = mapped_.document_term_offsets[ordinal + 1];
+    if (!mapped_.compressed) {
+        return { mapped_.document_terms + first, mapped_.document_terms + last };
+    }
+
+    // Сжатый прямой индекс хранит только термы, TF берётся из их списков словопозиций.
+    std::vector<TermFrequency> result;
+    result.reserve(last - first);
+    for (uint64_t i = first; i < last; ++i) {
+        const uint32_t term_id = mapped_.document_term_ids[i];
+        Posting posting{};
+        FindPosting(GetTermPostings(term_id), ordinal, posting);
+        result.push_back(TermFrequency{ term_id, posting.term_freq });
+    }
+    return result;
+}
+
+IteratorRange<const int*> SearchServer::GetSortedIds() const {
+    if (mapped_.snapshot) {
+        return { mapped_.sorted_ids, mapped_.sorted_ids + mapped_.document_count };
+    }
+    return { sorted_ids_.data(), sorted_ids_.data() + sorted_ids_.size() };
+}
+
+SearchServer::PostingList SearchServer::GetPostings(std::string_view word) const {
+    const uint32_t term_id = dictionary_.Find(word);
+    return term_id == TermDictionary::NO_TERM ? PostingList{} : GetTermPostings(term_id);
+}
+
+bool SearchServer::IsPostingBefore(const Posting& posting, uint32_t ordinal) {
+    return posting.ordinal < ordinal;
+}
+
+bool SearchServer::IsBlockBefore(const PostingBlock& block, uint32_t ordinal) {
+    return block.last_ordinal < ordinal;
+}
+
+SearchServer::PostingCursor SearchServer::SeekPosting(const PostingList& postings, uint32_t ordinal) {
+    PostingCursor cursor;
+    if (postings.blocks == nullptr) {
+        cursor.position = SkipTo(postings.first, postings.last, ordinal);
+    }
+    else {
+        cursor.block = std::lower_bound(postings.blocks, postings.blocks + postings.block_count, ordinal, IsBlockBefore)
+            - postings.blocks;
+    }
+    return cursor;
+}
+
+SearchServer::PostingRange SearchServer::ReadWindowPostings(const PostingList& postings, PostingCursor& cursor,
+    uint32_t window_begin, uint32_t window_end, std::vector<Posting>& buffer) const {
+    if (postings.blocks == nullptr) {
+        const Posting* first = cursor.position;
+        cursor.position = SkipTo(first, postings.last, window_end);
+        return { first, cursor.position };
     }
 
-    for (const auto& [key, val] : this->GetWordFrequencies(document_id)) {
-        word_to_document_freqs_[key].erase(document_id);
+    buffer.clear();
+    while (cursor.block < postings.block_count && postings.blocks[cursor.block].first_ordinal < window_end) {
+        const PostingBlock& block = postings.blocks[cursor.block];
+        const size_t offset = buffer.size();
+        buffer.resize(offset + block.count);
+        DecodeBlock(block, buffer.data() + offset);
+        if (block.last_ordinal >= window_end) {
+            break;
+        }
+        ++cursor.block;
+    }
+
+    const Posting* first = SkipTo(buffer.data(), buffer.data() + buffer.size(), window_begin);
+    return { first, SkipTo(first, buffer.data() + buffer.size(), window_end) };
+}
+
+void SearchServer::DecodeBlock(const PostingBlock& block, Posting* postings) const {
+    uint32_t ordinals[POSTING_BLOCK_SIZE];
+    uint32_t codes[POSTING_BLOCK_SIZE];
+    DecodePostingBlock(block, mapped_.posting_data, ordinals, codes);
+    for (uint32_t i = 0; i < block.count; ++i) {
+        postings[i] = Posting{ ordinals[i], mapped_.term_freq_codebook[codes[i]] };
     }
+}
 
-    documents_.erase(document_id);
-    document_to_word_freqs_.erase(document_id);
-    document_ids_.erase(document_id);
+bool SearchServer::FindPosting(const PostingList& postings, uint32_t ordinal, Posting& result) const {
+    if (postings.blocks == nullptr) {
+        const Posting* it = std::lower_bound(postings.first, postings.last, ordinal, IsPostingBefore);
+        if (it == postings.last || it->ordinal != ordinal) {
+            return false;
+        }
+        result = *it;
+        return true;
+    }
+
+    const PostingBlock* block = std::lower_bound(postings.blocks, postings.blocks + postings.block_count, ordinal, IsBlockBefore);
+    if (block == postings.blocks + postings.block_count || block->first_ordinal > ordinal) {
+        return false;
+    }
+    Posting block_postings[POSTING_BLOCK_SIZE];
+    DecodeBlock(*block, block_postings);
+    const Posting* it = std::lower_bound(block_postings, block_postings + block->count, ordinal, IsPostingBefore);
+    if (it == block_postings + block->count || it->ordinal != ordinal) {
+        return false;
+    }
+    result = *it;
+    return true;
+}
+
+bool SearchServer::IsRemovedOrdinal(uint32_t ordinal) const {
+    return (removed_bits_[ordinal / 64] >> (ordinal % 64)) & 1;
+}
+
+uint32_t SearchServer::CountTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+SearchServer::ResolvedQuery SearchServer::ResolveQuery(const Query& query, const CorpusStatistics* corpus) const {
+    ScopedStageTimer timer(ProfileStage::IDF);
+    ResolvedQuery result;
+    result.documents = GetDocumentColumns();
+    size_t plus_posting_count = 0;
+    size_t minus_posting_count = 0;
+
+    for (std::string_view word : query.plus_words) {
+        const uint32_t term_id = dictionary_.Find(word);
+        if (term_id == TermDictionary::NO_TERM) {
+            continue;
+        }
+        // Список может состоять из словопозиций удалённых документов.
+        if (GetDocumentFreq(term_id) > 0) {
+            const PostingList postings = GetTermPostings(term_id);
+            double inverse_document_freq = 0.0;
+            if (corpus == nullptr) {
+                inverse_document_freq = GetInverseDocumentFreq(term_id);
+            }
+            else {
+                const auto it = corpus->document_freqs.find(word);
+                inverse_document_freq = it != corpus->document_freqs.end()
+                    ? log(corpus->document_count * 1.0 / it->second)
+                    : GetInverseDocumentFreq(term_id);
+            }
+            result.plus_terms.push_back({ postings, inverse_document_freq,
+                inverse_document_freq * GetMaxTermFreq(term_id) });
+            plus_posting_count += postings.size;
+        }
+    }
+
+    std::stable_sort(result.plus_terms.begin(), result.plus_terms.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.max_relevance > rhs.max_relevance;
+        });
+    result.max_relevance_suffix.assign(result.plus_terms.size() + 1, 0.0);
+    for (size_t i = result.plus_terms.size(); i > 0; --i) {
+        result.max_relevance_suffix[i - 1] = result.max_relevance_suffix[i] + result.plus_terms[i - 1].max_relevance;
+    }
+
+    for (std::string_view word : query.minus_words) {
+        const PostingList postings = GetPostings(word);
+        if (postings.size > 0) {
+            result.minus_postings.push_back(postings);
+            minus_posting_count += postings.size;
+        }
+    }
+
+    result.exclude_before_scoring = minus_posting_count <= plus_posting_count;
+    if (!pending_removals_.empty()) {
+        result.removed_bits = removed_bits_.data();
+    }
+    return result;
+}
+
+SearchServer::PostingCursors SearchServer::SeekPostings(const ResolvedQuery& query, uint32_t ordinal) {
+    PostingCursors cursors;
+    cursors.plus.reserve(query.plus_terms.size());
+    for (const auto& term : query.plus_terms) {
+        cursors.plus.push_back(SeekPosting(term.postings, ordinal));
+    }
+    cursors.minus.reserve(query.minus_postings.size());
+    for (const PostingList& postings : query.minus_postings) {
+        cursors.minus.push_back(SeekPosting(postings, ordinal));
+    }
+    return cursors;
+}
+
+const SearchServer::Posting* SearchServer::SkipTo(const Posting* first, const Posting* last, uint32_t ordinal) {
+    size_t step = 1;
+    while (step < static_cast<size_t>(last - first) && first[step].ordinal < ordinal) {
+        first += step;
+        step *= 2;
+    }
+    return std::lower_bound(first, first + std::min(step + 1, static_cast<size_t>(last - first)), ordinal, IsPostingBefore);
+}
+
+void SearchServer::RaiseThreshold(std::atomic<double>& shared_threshold, double threshold) {
+    double current = shared_threshold.load(std::memory_order_relaxed);
+    while (threshold > current && !shared_threshold.compare_exchange_weak(current, threshold, std::memory_order_relaxed)) {
+    }
+}
+
+bool SearchServer::IsExpired(Deadline deadline) {
+    return deadline != NO_DEADLINE && std::chrono::steady_clock::now() >= deadline;
+}
+
+SearchServer::ScoreAccumulator& SearchServer::GetThreadAccumulator() {
+    thread_local ScoreAccumulator accumulator{
+        std::vector<double>(SCORE_WINDOW_SIZE),
+        std::vector<SlotState>(SCORE_WINDOW_SIZE, SlotState::EMPTY),
+        {},
+        {},
+        {},
+        {},
+        {}
+    };
+    return accumulator;
+}
+
+uint32_t SearchServer::FindOrdinal(int document_id) const {
+    const auto ids = GetSortedIds();
+    const int* it = std::lower_bound(ids.begin(), ids.end(), document_id);
+    if (it != ids.end() && *it == document_id) {
+        const size_t position = it - ids.begin();
+        const uint32_t ordinal = mapped_.snapshot ? mapped_.sorted_ordinals[position] : sorted_ordinals_[position];
+        return removed_id_count_ > 0 && IsRemovedOrdinal(ordinal) ? NO_ORDINAL : ordinal;
+    }
+
+    const auto inserted = std::lower_bound(inserted_ids_.begin(), inserted_ids_.end(), document_id);
+    if (inserted != inserted_ids_.end() && *inserted == document_id) {
+        return inserted_ordinals_[inserted - inserted_ids_.begin()];
+    }
+    return NO_ORDINAL;
+}
+
+uint32_t SearchServer::GetOrdinal(int document_id) const {
+    const uint32_t ordinal = FindOrdinal(document_id);
+    if (ordinal == NO_ORDINAL) {
+        throw std::out_of_range("incorrect document id"s);
+    }
+    return ordinal;
+}
+
+std::map<std::string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    std::map<std::string_view, double> result;
+
+    const uint32_t ordinal = FindOrdinal(document_id);
+    if (ordinal == NO_ORDINAL) {
+        return result;
+    }
+
+    for (const TermFrequency& item : GetDocumentTerms(ordinal)) {
+        result.emplace(dictionary_.GetTerm(item.term_id), item.term_freq);
+    }
+    return result;
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
 }
 
 void SearchServer::RemoveDocument(std::execution::sequenced_policy seq, int document_id) {
-    //LOG_DURATION_STREAM("remove documents", std::cout);
+    RemoveDocumentBatch(seq, { document_id });
+}
+
+void SearchServer::RemoveDocument(std::execution::parallel_policy par, int document_id) {
+    RemoveDocumentBatch(par, { document_id });
+}
 
-    const std::map<std::string_view, double>& word_freqs = GetWordFrequencies(document_id);
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    RemoveDocumentBatch(std::execution::seq, document_ids);
+}
+
+void SearchServer::RemoveDocuments(std::execution::sequenced_policy seq, const std::vector<int>& document_ids) {
+    RemoveDocumentBatch(seq, document_ids);
+}
 
-    if (word_freqs.empty()) {
+void SearchServer::RemoveDocuments(std::execution::parallel_policy par, const std::vector<int>& document_ids) {
+    RemoveDocumentBatch(par, document_ids);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::RemoveDocumentBatch(ExecutionPolicy&& policy, const std::vector<int>& document_ids) {
+    ScopedStageTimer timer(ProfileStage::REMOVE_DOCUMENT);
+    CheckWritable();
+
+    std::vector<uint32_t> ordinals;
+    ordinals.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        const uint32_t ordinal = FindOrdinal(document_id);
+        if (ordinal != NO_ORDINAL) {
+            ordinals.push_back(ordinal);
+        }
+    }
+    if (ordinals.empty()) {
         return;
     }
+    std::sort(ordinals.begin(), ordinals.end());
+    ordinals.erase(std::unique(ordinals.begin(), ordinals.end()), ordinals.end());
+    ++index_version_;
+    ++result_cache_version_;
+
+    // Словопозиции, прямой индекс и место в основном списке идентификаторов остаются
+    // до очистки, документ исключается битом.
+    for (const uint32_t ordinal : ordinals) {
+        for (const TermFrequency& item : document_terms_[ordinal]) {
+            --term_statistics_[item.term_id].document_freq;
+        }
+        removed_bits_[ordinal / 64] |= uint64_t{ 1 } << (ordinal % 64);
+        pending_removals_.push_back(ordinal);
+        documents_.texts[ordinal] = {};    // байты остаются в арене до её пересоздания
+    }
 
-    std::for_each(seq,
-        word_freqs.begin(),
-        word_freqs.end(),
-        [document_id, this](const auto& item) {
-            word_to_document_freqs_.at(item.first).erase(document_id);
+    removed_id_count_ += ordinals.size();
+
+    // Список вставок короткий, удалённые убираются из него сразу.
+    size_t kept = 0;
+    for (size_t i = 0; i < inserted_ids_.size(); ++i) {
+        if (!IsRemovedOrdinal(inserted_ordinals_[i])) {
+            inserted_ids_[kept] = inserted_ids_[i];
+            inserted_ordinals_[kept] = inserted_ordinals_[i];
+            ++kept;
         }
-    );
+    }
+    removed_id_count_ -= inserted_ids_.size() - kept;
+    inserted_ids_.resize(kept);
+    inserted_ordinals_.resize(kept);
 
-    documents_.erase(document_id);
-    document_to_word_freqs_.erase(document_id);
-    document_ids_.erase(document_id);
+    if (pending_removals_.size() >= std::max(MIN_PURGE_BATCH_SIZE, GetDocumentCount() / 8)) {
+        PurgePostings(policy);
+    }
 }
 
-void SearchServer::RemoveDocument(std::execution::parallel_policy par, int document_id) {
-    //LOG_DURATION_STREAM("remove documents", std::cout);
+void SearchServer::UpdateStatus(const std::vector<int>& document_ids, DocumentStatus status) {
+    CheckWritable();
 
-    const std::map<std::string_view, double>& word_freqs = GetWordFrequencies(document_id);
+    // Статус не влияет на IDF и разрешённые термы, устаревает только кэш выдачи.
+    bool changed = false;
+    for (const int document_id : document_ids) {
+        const uint32_t ordinal = FindOrdinal(document_id);
+        if (ordinal != NO_ORDINAL && documents_.statuses[ordinal] != status) {
+            documents_.statuses[ordinal] = status;
+            changed = true;
+        }
+    }
+    if (changed) {
+        ++result_cache_version_;
+    }
+}
+
+void SearchServer::PurgeRemovedDocuments() {
+    PurgeRemovedDocuments(std::execution::seq);
+}
+
+void SearchServer::PurgeRemovedDocuments(std::execution::sequenced_policy seq) {
+    CheckWritable();
+    PurgePostings(seq);
+}
 
-    if (word_freqs.empty()) {
+void SearchServer::PurgeRemovedDocuments(std::execution::parallel_policy par) {
+    CheckWritable();
+    PurgePostings(par);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::PurgePostings(ExecutionPolicy&& policy) {
+    if (pending_removals_.empty()) {
         return;
     }
+    // Списки переписываются на месте: разрешённые раньше запросы указывают в старые.
+    ++index_version_;
+
+    std::vector<uint32_t> term_ids;
+    for (const uint32_t ordinal : pending_removals_) {
+        for (const TermFrequency& item : document_terms_[ordinal]) {
+            term_ids.push_back(item.term_id);
+        }
+    }
+    std::sort(policy, term_ids.begin(), term_ids.end());
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+
+    // Каждая задача переписывает список одного терма, поэтому задачи не пересекаются.
+    // Оценка TF пересчитывается по оставшимся словопозициям.
+    std::for_each(policy, term_ids.begin(), term_ids.end(), [this](uint32_t term_id) {
+        auto& postings = postings_[term_id];
+        postings.erase(std::remove_if(postings.begin(), postings.end(), [this](const Posting& posting) {
+            return IsRemovedOrdinal(posting.ordinal);
+            }), postings.end());
+
+        double max_term_freq = 0.0;
+        for (const Posting& posting : postings) {
+            max_term_freq = std::max(max_term_freq, posting.term_freq);
+        }
+        term_statistics_[term_id].max_term_freq = max_term_freq;
+        });
 
-    std::for_each(par,
-        word_freqs.begin(),
-        word_freqs.end(),
-        [document_id, this](const auto& item) {
-            word_to_document_freqs_.at(item.first).erase(document_id);
+    size_t kept = 0;
+    for (size_t i = 0; i < sorted_ids_.size(); ++i) {
+        if (!IsRemovedOrdinal(sorted_ordinals_[i])) {
+            sorted_ids_[kept] = sorted_ids_[i];
+            sorted_ordinals_[kept] = sorted_ordinals_[i];
+            ++kept;
         }
-    );
+    }
+    sorted_ids_.resize(kept);
+    sorted_ordinals_.resize(kept);
+    removed_id_count_ = 0;
 
-    documents_.erase(document_id);
-    document_to_word_freqs_.erase(document_id);
-    document_ids_.erase(document_id);
+    for (const uint32_t ordinal : pending_removals_) {
+        document_terms_[ordinal] = std::vector<TermFrequency>();
+        removed_bits_[ordinal / 64] &= ~(uint64_t{ 1 } << (ordinal % 64));
+    }
+    pending_removals_.clear();
 }
 
+void SearchServer::SaveSnapshot(const std::string& path, PostingFormat format) const {
+    // Живые документы получают новые порядковые номера подряд в прежнем порядке,
+    // поэтому списки словопозиций остаются отсортированными.
+    const DocumentColumnsView documents = GetDocumentColumns();
+    std::vector<uint32_t> new_ordinals(documents.ordinal_count, NO_ORDINAL);
+    std::vector<uint32_t> live_ordinals;
+    live_ordinals.reserve(GetDocumentCount());
+    for (auto it = begin(), last = end(); it != last; ++it) {
+        live_ordinals.push_back(it.GetOrdinal());
+    }
+    std::sort(live_ordinals.begin(), live_ordinals.end());
+    for (uint32_t i = 0; i < live_ordinals.size(); ++i) {
+        new_ordinals[live_ordinals[i]] = i;
+    }
+
+    SnapshotWriter writer(path);
+
+    std::string stop_words_text;
+    for (const std::string& stop_word : stop_words_) {
+        stop_words_text += stop_word;
+        stop_words_text += ' ';
+    }
+    writer.WriteSection(SnapshotSection::STOP_WORDS, stop_words_text.data(), stop_words_text.size());
+
+    const size_t term_count = dictionary_.size();
+    std::vector<uint64_t> term_offsets{ 0 };
+    std::string term_bytes;
+    for (uint32_t term_id = 0; term_id < term_count; ++term_id) {
+        term_bytes += dictionary_.GetTerm(term_id);
+        term_offsets.push_back(term_bytes.size());
+    }
+    writer.WriteSection(SnapshotSection::TERM_SLOTS, dictionary_.GetSlots());
+    writer.WriteSection(SnapshotSection::TERM_OFFSETS, term_offsets);
+    writer.WriteSection(SnapshotSection::TERM_BYTES, term_bytes.data(), term_bytes.size());
+
+    // Оценка TF уточняется по живым словопозициям, IDF считается один раз для неизменного индекса.
+    std::vector<uint64_t> posting_offsets{ 0 };
+    std::vector<Posting> postings;
+    std::vector<double> max_term_freqs(term_count, 0.0);
+    std::vector<double> inverse_document_freqs(term_count, 0.0);
+    std::vector<Posting> buffer;
+    for (uint32_t term_id = 0; term_id < term_count; ++term_id) {
+        const PostingList term_postings = GetTermPostings(term_id);
+        PostingCursor cursor = SeekPosting(term_postings, 0);
+        for (const Posting& posting : ReadWindowPostings(term_postings, cursor, 0, NO_ORDINAL, buffer)) {
+            if (new_ordinals[posting.ordinal] == NO_ORDINAL) {
+                continue;    // удалённый документ, ещё не вычищенный из списка
+            }
+            postings.push_back(Posting{ new_ordinals[posting.ordinal], posting.term_freq });
+            max_term_freqs[term_id] = std::max(max_term_freqs[term_id], posting.term_freq);
+        }
+        posting_offsets.push_back(postings.size());
+        if (GetDocumentFreq(term_id) > 0) {
+            inverse_document_freqs[term_id] = ComputeWordInverseDocumentFreq(term_id);
+        }
+    }
+    writer.WriteSection(SnapshotSection::TERM_MAX_FREQS, max_term_freqs);
+    writer.WriteSection(SnapshotSection::TERM_IDFS, inverse_document_freqs);
+    writer.WriteSection(SnapshotSection::POSTING_OFFSETS, posting_offsets);
+    if (format == PostingFormat::COMPRESSED) {
+        writer.SetFlags(SnapshotHeader::COMPRESSED_POSTINGS);
+        WriteCompressedPostings(writer, posting_offsets, postings);
+    }
+    else {
+        writer.WriteSection(SnapshotSection::POSTINGS, postings);
+    }
 
+    std::vector<uint64_t> document_term_offsets{ 0 };
+    std::vector<TermFrequency> document_terms;
+    std::vector<int> ids, ratings;
+    std::vector<DocumentStatus> statuses;
+    for (const uint32_t ordinal : live_ordinals) {
+        const std::vector<TermFrequency> terms = GetDocumentTerms(ordinal);
+        document_terms.insert(document_terms.end(), terms.begin(), terms.end());
+        document_term_offsets.push_back(document_terms.size());
+        ids.push_back(documents.ids[ordinal]);
+        ratings.push_back(documents.ratings[ordinal]);
+        statuses.push_back(documents.statuses[ordinal]);
+    }
+    writer.WriteSection(SnapshotSection::DOCUMENT_TERM_OFFSETS, document_term_offsets);
+    if (format == PostingFormat::COMPRESSED) {
+        std::vector<uint32_t> document_term_ids;
+        document_term_ids.reserve(document_terms.size());
+        for (const TermFrequency& item : document_terms) {
+            document_term_ids.push_back(item.term_id);
+        }
+        writer.WriteSection(SnapshotSection::DOCUMENT_TERM_IDS, document_term_ids);
+    }
+    else {
+        writer.WriteSection(SnapshotSection::DOCUMENT_TERMS, document_terms);
+    }
+    writer.WriteSection(SnapshotSection::DOCUMENT_IDS, ids);
+    writer.WriteSection(SnapshotSection::DOCUMENT_RATINGS, ratings);
+    writer.WriteSection(SnapshotSection::DOCUMENT_STATUSES, statuses);
+
+    std::vector<int> sorted_ids;
+    std::vector<uint32_t> sorted_ordinals;
+    sorted_ids.reserve(live_ordinals.size());
+    sorted_ordinals.reserve(live_ordinals.size());
+    for (auto it = begin(), last = end(); it != last; ++it) {
+        sorted_ids.push_back(*it);
+        sorted_ordinals.push_back(new_ordinals[it.GetOrdinal()]);
+    }
+    writer.WriteSection(SnapshotSection::SORTED_IDS, sorted_ids);
+    writer.WriteSection(SnapshotSection::SORTED_ORDINALS, sorted_ordinals);
+
+    writer.Finish();
+}
+
+void SearchServer::WriteCompressedPostings(SnapshotWriter& writer, const std::vector<uint64_t>& posting_offsets,
+    const std::vector<Posting>& postings) {
+    // Частые значения TF получают меньшие коды, чтобы в блоках хватало меньшей ширины.
+    std::unordered_map<double, size_t> term_freq_counts;
+    for (const Posting& posting : postings) {
+        ++term_freq_counts[posting.term_freq];
+    }
+    std::vector<std::pair<double, size_t>> sorted_term_freqs(term_freq_counts.begin(), term_freq_counts.end());
+    std::sort(sorted_term_freqs.begin(), sorted_term_freqs.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+        });
+    std::vector<double> codebook;
+    std::unordered_map<double, uint32_t> codes;
+    for (const auto& [term_freq, count] : sorted_term_freqs) {
+        codes.emplace(term_freq, static_cast<uint32_t>(codebook.size()));
+        codebook.push_back(term_freq);
+    }
+
+    std::vector<uint64_t> block_offsets{ 0 };
+    std::vector<PostingBlock> blocks;
+    std::vector<uint64_t> data;
+    uint32_t ordinals[POSTING_BLOCK_SIZE];
+    uint32_t block_codes[POSTING_BLOCK_SIZE];
+    for (size_t term_id = 0; term_id + 1 < posting_offsets.size(); ++term_id) {
+        for (uint64_t first = posting_offsets[term_id]; first < posting_offsets[term_id + 1]; first += POSTING_BLOCK_SIZE) {
+            const size_t count = std::min<uint64_t>(POSTING_BLOCK_SIZE, posting_offsets[term_id + 1] - first);
+            for (size_t i = 0; i < count; ++i) {
+                ordinals[i] = postings[first + i].ordinal;
+                block_codes[i] = codes.at(postings[first + i].term_freq);
+            }
+            blocks.push_back(EncodePostingBlock(ordinals, block_codes, count, data));
+        }
+        block_offsets.push_back(blocks.size());
+    }
+
+    writer.WriteSection(SnapshotSection::POSTING_BLOCK_OFFSETS, block_offsets);
+    writer.WriteSection(SnapshotSection::POSTING_BLOCKS, blocks);
+    writer.WriteSection(SnapshotSection::POSTING_DATA, data);
+    writer.WriteSection(SnapshotSection::TERM_FREQ_CODEBOOK, codebook);
+}
+
+SearchServer SearchServer::OpenSnapshot(const std::string& path) {
+    auto snapshot = std::make_unique<const IndexSnapshot>(path);
+    const auto stop_words = snapshot->GetSection<char>(SnapshotSection::STOP_WORDS);
+
+    SearchServer server(std::string_view(stop_words.data, stop_words.size));
+    server.AttachSnapshot(std::move(snapshot));
+    return server;
+}
+
+void SearchServer::AttachSnapshot(std::unique_ptr<const IndexSnapshot> snapshot) {
+    const auto term_slots = snapshot->GetSection<uint32_t>(SnapshotSection::TERM_SLOTS);
+    const auto term_offsets = snapshot->GetSection<uint64_t>(SnapshotSection::TERM_OFFSETS);
+    const auto term_bytes = snapshot->GetSection<char>(SnapshotSection::TERM_BYTES);
+    const auto max_term_freqs = snapshot->GetSection<double>(SnapshotSection::TERM_MAX_FREQS);
+    const auto inverse_document_freqs = snapshot->GetSection<double>(SnapshotSection::TERM_IDFS);
+    const auto posting_offsets = snapshot->GetSection<uint64_t>(SnapshotSection::POSTING_OFFSETS);
+    const auto postings = snapshot->GetSection<Posting>(SnapshotSection::POSTINGS);
+    const auto document_term_offsets = snapshot->GetSection<uint64_t>(SnapshotSection::DOCUMENT_TERM_OFFSETS);
+    const auto document_terms = snapshot->GetSection<TermFrequency>(SnapshotSection::DOCUMENT_TERMS);
+    const auto ids = snapshot->GetSection<int>(SnapshotSection::DOCUMENT_IDS);
+    const auto ratings = snapshot->GetSection<int>(SnapshotSection::DOCUMENT_RATINGS);
+    const auto statuses = snapshot->GetSection<DocumentStatus>(SnapshotSection::DOCUMENT_STATUSES);
+    const auto sorted_ids = snapshot->GetSection<int>(SnapshotSection::SORTED_IDS);
+    const auto sorted_ordinals = snapshot->GetSection<uint32_t>(SnapshotSection::SORTED_ORDINALS);
+    const auto posting_block_offsets = snapshot->GetSection<uint64_t>(SnapshotSection::POSTING_BLOCK_OFFSETS);
+    const auto posting_blocks = snapshot->GetSection<PostingBlock>(SnapshotSection::POSTING_BLOCKS);
+    const auto posting_data = snapshot->GetSection<uint64_t>(SnapshotSection::POSTING_DATA);
+    const auto term_freq_codebook = snapshot->GetSection<double>(SnapshotSection::TERM_FREQ_CODEBOOK);
+    const auto document_term_ids = snapshot->GetSection<uint32_t>(SnapshotSection::DOCUMENT_TERM_IDS);
+    const bool compressed = (snapshot->GetFlags() & SnapshotHeader::COMPRESSED_POSTINGS) != 0;
+
+    // Проверяются только размеры разделов: содержимое снимка считается доверенным,
+    // полная проверка потребовала бы прочитать весь файл.
+    const size_t term_count = max_term_freqs.size;
+    const size_t ordinal_count = ids.size;
+    const bool consistent = term_offsets.size == term_count + 1
+        && term_offsets.data[term_count] == term_bytes.size
+        && inverse_document_freqs.size == term_count
+        && posting_offsets.size == term_count + 1
+        && document_term_offsets.size == ordinal_count + 1
+        && (compressed
+            ? posting_block_offsets.size == term_count + 1
+                && posting_block_offsets.data[term_count] == posting_blocks.size
+                && document_term_offsets.data[ordinal_count] == document_term_ids.size
+            : posting_offsets.data[term_count] == postings.size
+                && document_term_offsets.data[ordinal_count] == document_terms.size)
+        && ratings.size == ordinal_count
+        && statuses.size == ordinal_count
+        && sorted_ids.size == ordinal_count
+        && sorted_ordinals.size == ordinal_count;
+    if (!consistent) {
+        throw std::runtime_error("Index snapshot is inconsistent"s);
+    }
+
+    dictionary_.AttachMapped(term_slots.data, term_slots.size, term_offsets.data, term_bytes.data, term_count);
+    mapped_.posting_offsets = posting_offsets.data;
+    mapped_.postings = postings.data;
+    mapped_.max_term_freqs = max_term_freqs.data;
+    mapped_.inverse_document_freqs = inverse_document_freqs.data;
+    mapped_.document_term_offsets = document_term_offsets.data;
+    mapped_.document_terms = document_terms.data;
+    mapped_.compressed = compressed;
+    mapped_.posting_block_offsets = posting_block_offsets.data;
+    mapped_.posting_blocks = posting_blocks.data;
+    mapped_.posting_data = posting_data.data;
+    mapped_.term_freq_codebook = term_freq_codebook.data;
+    mapped_.document_term_ids = document_term_ids.data;
+    mapped_.documents = { ids.data, ratings.data, statuses.data, static_cast<uint32_t>(ordinal_count) };
+    mapped_.sorted_ids = sorted_ids.data;
+    mapped_.sorted_ordinals = sorted_ordinals.data;
+    mapped_.document_count = ordinal_count;
+    mapped_.snapshot = std::move(snapshot);
+}
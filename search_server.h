@@ -1,23 +1,44 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <map>
 #include <cmath>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <optional>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <execution>
+#include <iterator>
+#include <numeric>
+#include <thread>
 #include <type_traits>
 
 #include "document.h"
+#include "index_snapshot.h"
 #include "paginator.h"
+#include "posting_codec.h"
+#include "query_result_cache.h"
 #include "read_input_functions.h"
 #include "string_processing.h"
-#include "concurrent_map.h"
-#include "log_duration.h"
+#include "term_dictionary.h"
+#include "work_stealing_pool.h"
+#include "stage_profiler.h"
+#include "text_arena.h"
+#include "top_documents.h"
 
-#define SMALL_RANGE_FOR_COMPARE 1e-6 // для сравнения вещественных чисел.
+// Поиск прерван: срок запроса наступил раньше, чем просмотрены все документы.
+class DeadlineExceeded : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
 
 /**
 	* Ядро поискового сервера с добавленными методами, 
@@ -25,6 +46,12 @@
 	**/
 class SearchServer {
 public:
+    // Размер выдачи FindTopDocuments, если он не задан явно.
+    static constexpr size_t DEFAULT_RESULT_DOCUMENT_COUNT = 5;
+
+    using Deadline = std::chrono::steady_clock::time_point;
+    static constexpr Deadline NO_DEADLINE = Deadline::max();
+
     template <typename StringContainer>
     SearchServer(const StringContainer& stop_words);
 
@@ -32,37 +59,115 @@ public:
 
     SearchServer(std::string_view stop_words_text);
 
+    // Сервер только перемещается: кэш IDF в статистике термов атомарный, а словарь и
+    // списки словопозиций указывают в арену текстов и в отображённый снимок, которые
+    // при перемещении остаются на месте.
+    SearchServer(const SearchServer&) = delete;
+    SearchServer& operator=(const SearchServer&) = delete;
+    SearchServer(SearchServer&&) = default;
+
+    // Формат списков словопозиций в снимке.
+    enum class PostingFormat {
+        PLAIN,         // массивы (номер, TF) и прямой индекс с TF, 32 байта на словопозицию
+        COMPRESSED,    // блоки упакованных разностей номеров и кодов TF, прямой индекс без TF
+    };
+
+    // Сохраняет словарь, списки словопозиций, данные документов и стоп-слова в
+    // бинарный снимок. Удалённые документы в снимок не попадают, порядковые
+    // номера уплотняются. Тексты документов не сохраняются.
+    // Сжатие не теряет точности: TF хранится кодом в таблице различных значений.
+    void SaveSnapshot(const std::string& path, PostingFormat format = PostingFormat::PLAIN) const;
+
+    // Открывает снимок отображением в память: сервер готов к запросам без разбора
+    // и перестроения индекса, списки словопозиций читаются прямо из файла.
+    // Такой сервер только для чтения: AddDocument и RemoveDocument бросают logic_error.
+    static SearchServer OpenSnapshot(const std::string& path);
+
+    bool IsReadOnly() const;
+
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Документ для пакетного добавления; текст должен жить до конца вызова AddDocuments.
+    struct DocumentInput {
+        int id;
+        std::string_view text;
+        DocumentStatus status;
+        std::vector<int> ratings;
+    };
+
+    // Добавляет пакет документов: тексты разбираются по частям пакета в частичные
+    // индексы, которые затем сливаются в основной за один проход. Результат тот же,
+    // что у AddDocument в порядке пакета. Если хотя бы один документ некорректен,
+    // бросает invalid_argument, и индекс не меняется.
+    void AddDocuments(const std::vector<DocumentInput>& documents);
+
+    void AddDocuments(std::execution::sequenced_policy seq, const std::vector<DocumentInput>& documents);
+
+    void AddDocuments(std::execution::parallel_policy par, const std::vector<DocumentInput>& documents);
+
     template <typename DocumentPredicate, typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
    
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
     
     template <typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
     
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
     
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
     
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
+    // Статистика коллекции для IDF, когда документы разнесены по нескольким
+    // серверам (сегментам): общее число документов и документная частота слов запроса.
+    struct CorpusStatistics {
+        size_t document_count = 0;
+        std::map<std::string_view, size_t> document_freqs;
+    };
+
+    // Добавляет в statistics документы этого сервера и частоты плюс-слов запроса.
+    void AddCorpusStatistics(std::string_view raw_query, CorpusStatistics& statistics) const;
+
+    // Поиск с IDF по статистике коллекции: релевантность документов разных сегментов
+    // сравнима, если статистика собрана по всем сегментам.
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, const CorpusStatistics& corpus,
+        DocumentPredicate document_predicate, size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
     size_t GetDocumentCount() const;
 
+    // Включает кэш выдачи FindTopDocuments по статусу на capacity запросов; 0 выключает.
+    // Любое изменение документов делает записи кэша устаревшими.
+    void EnableResultCache(size_t capacity);
+
+    // Попадания и промахи с момента включения кэша.
+    QueryResultCache::Statistics GetResultCacheStatistics() const;
+
+    // Живые документы по возрастанию идентификатора в виде пакета для AddDocuments,
+    // рейтинг - единственная оценка. Тексты указывают в сервер. Для сервера из снимка
+    // бросает logic_error: тексты в снимке не хранятся.
+    std::vector<DocumentInput> ExportDocuments() const;
+
     std::map<int, std::map<std::string_view, double>> GetDocumentWordsFreqs();
 
-    auto begin() const {
-        return document_ids_.begin();
-    }
+    class DocumentIdIterator;
 
-    auto end() const {
-        return document_ids_.end();
-    }
+    // Идентификаторы документов по возрастанию.
+    DocumentIdIterator begin() const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    DocumentIdIterator end() const;
+
+    bool ContainsDocument(int document_id) const;
+
+    // Строится по прямому индексу документа; для неизвестного идентификатора пуст.
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
 
     void RemoveDocument(int document_id);
 
@@ -70,24 +175,287 @@ public:
 
     void RemoveDocument(std::execution::parallel_policy par, int document_id);
 
+    // Удаляет пакет документов за один проход по списку идентификаторов.
+    // Неизвестные и повторные идентификаторы пропускаются.
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    void RemoveDocuments(std::execution::sequenced_policy seq, const std::vector<int>& document_ids);
+
+    void RemoveDocuments(std::execution::parallel_policy par, const std::vector<int>& document_ids);
+
+    // Меняет статус документов, не трогая индекс. Неизвестные идентификаторы пропускаются.
+    void UpdateStatus(const std::vector<int>& document_ids, DocumentStatus status);
+
+    // RemoveDocument лишь отмечает документ удалённым: запросы его пропускают, а
+    // словопозиции вычищаются пакетом, когда отметок накопится достаточно. Метод
+    // вычищает их сразу; параллельная версия обрабатывает термы независимыми задачами.
+    void PurgeRemovedDocuments();
+
+    void PurgeRemovedDocuments(std::execution::sequenced_policy seq);
+
+    void PurgeRemovedDocuments(std::execution::parallel_policy par);
+
     template <typename ExecutionPolicy>
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
 
+    class PreparedQuery;
+
+    // Разбирает запрос и разрешает его термы для многократного выполнения. Ошибки
+    // запроса бросаются здесь, как в FindTopDocuments.
+    PreparedQuery PrepareQuery(std::string_view raw_query) const;
+
+    // Как PrepareQuery, но без подготовки к MatchDocument - для запросов, которые
+    // только ищутся. MatchDocument по такому запросу разрешает термы при каждом вызове.
+    PreparedQuery PrepareSearchQuery(std::string_view raw_query) const;
+
+    // Число словопозиций в списках термов запроса - оценка стоимости поиска.
+    size_t GetPostingCount(const PreparedQuery& query) const;
+
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentPredicate document_predicate,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentStatus status,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t result_count = DEFAULT_RESULT_DOCUMENT_COUNT) const;
+
+    // Срок проверяется перед каждым окном документов: если он наступил, поиск
+    // прерывается и бросается DeadlineExceeded.
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentStatus status,
+        size_t result_count, Deadline deadline) const;
+
+    // Найденные слова указывают в query.
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, const PreparedQuery& query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const PreparedQuery& query, int document_id) const;
+
+    using MatchResult = std::tuple<std::vector<std::string_view>, DocumentStatus>;
+
+    // MatchDocument для пакета документов: результаты в порядке document_ids. Термы
+    // запроса ищутся в словаре один раз, затем пересекаются с прямым индексом каждого
+    // документа слиянием. Для неизвестного идентификатора бросает out_of_range до поиска.
+    template <typename ExecutionPolicy>
+    std::vector<MatchResult> MatchDocuments(ExecutionPolicy&& policy, std::string_view raw_query, const std::vector<int>& document_ids) const;
+    std::vector<MatchResult> MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<MatchResult> MatchDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, const std::vector<int>& document_ids) const;
+    std::vector<MatchResult> MatchDocuments(const PreparedQuery& query, const std::vector<int>& document_ids) const;
+
 private:
-    const int MAX_RESULT_DOCUMENT_COUNT = 5;
+    // Данные документов по колонкам, индекс - внутренний порядковый номер документа.
+    // Номера выдаются по порядку в AddDocument и не переиспользуются после удаления.
+    struct DocumentColumns {
+        std::vector<int> ids;
+        std::vector<int> ratings;
+        std::vector<DocumentStatus> statuses;
+        std::vector<TextArena::TextRef> texts;
+    };
 
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
-        std::string str;
+    // Колонки документов для чтения: указывают в DocumentColumns или в снимок.
+    struct DocumentColumnsView {
+        const int* ids = nullptr;
+        const int* ratings = nullptr;
+        const DocumentStatus* statuses = nullptr;
+        uint32_t ordinal_count = 0;
+    };
+
+    static constexpr uint32_t NO_ORDINAL = std::numeric_limits<uint32_t>::max();
+
+    // Элемент списка словопозиций: списки отсортированы по порядковому номеру документа.
+    // Поле reserved занимает выравнивание перед term_freq, чтобы в снимок не попадали
+    // неинициализированные байты.
+    struct Posting {
+        Posting() = default;
+
+        Posting(uint32_t ordinal, double term_freq)
+            : ordinal(ordinal)
+            , term_freq(term_freq) {
+        }
+
+        uint32_t ordinal = 0;
+        uint32_t reserved = 0;
+        double term_freq = 0.0;
+    };
+
+    static_assert(sizeof(Posting) == 16);
+
+    using PostingRange = IteratorRange<const Posting*>;
+
+    // Элемент прямого индекса: термы документа с их TF, отсортированы по терму.
+    // Как и в Posting, выравнивание занято полем reserved.
+    struct TermFrequency {
+        TermFrequency() = default;
+
+        TermFrequency(uint32_t term_id, double term_freq)
+            : term_id(term_id)
+            , term_freq(term_freq) {
+        }
+
+        uint32_t term_id = 0;
+        uint32_t reserved = 0;
+        double term_freq = 0.0;
+    };
+
+    static_assert(sizeof(TermFrequency) == 16);
+
+    // Список словопозиций терма: несжатый массив или сжатые блоки снимка.
+    struct PostingList {
+        const Posting* first = nullptr;
+        const Posting* last = nullptr;
+        const PostingBlock* blocks = nullptr;    // задан только у сжатого списка
+        size_t block_count = 0;
+        size_t size = 0;
+    };
+
+    // Позиция в списке: словопозиция несжатого списка или блок сжатого.
+    struct PostingCursor {
+        const Posting* position = nullptr;
+        size_t block = 0;
+    };
+
+    // Статистика терма. IDF вычисляется лениво и хранится вместе с версией индекса,
+    // для которой он посчитан: любое изменение индекса увеличивает версию, и
+    // следующий запрос с этим термом пересчитывает значение.
+    struct TermStatistics {
+        double max_term_freq = 0.0;    // оценка сверху TF по списку, уточняется при очистке
+        uint32_t document_freq = 0;    // живые документы с термом, без отмеченных удалёнными
+        std::atomic<uint64_t> version{ 0 };
+        std::atomic<double> inverse_document_freq{ 0.0 };
+    };
+
+    // Индекс, открытый из снимка: указатели на разделы отображённого файла.
+    // Для построенного в памяти индекса snapshot пуст и поля не используются.
+    struct MappedIndex {
+        std::unique_ptr<const IndexSnapshot> snapshot;
+        const uint64_t* posting_offsets = nullptr;    // term_count + 1 смещений
+        const Posting* postings = nullptr;
+        const double* max_term_freqs = nullptr;
+        const double* inverse_document_freqs = nullptr;    // индекс неизменен, IDF посчитан при сохранении
+        const uint64_t* document_term_offsets = nullptr;    // ordinal_count + 1 смещений
+        const TermFrequency* document_terms = nullptr;
+        // Сжатый формат: postings и document_terms не заданы.
+        bool compressed = false;
+        const uint64_t* posting_block_offsets = nullptr;    // term_count + 1 смещений
+        const PostingBlock* posting_blocks = nullptr;
+        const uint64_t* posting_data = nullptr;
+        const double* term_freq_codebook = nullptr;
+        const uint32_t* document_term_ids = nullptr;
+        DocumentColumnsView documents;
+        const int* sorted_ids = nullptr;
+        const uint32_t* sorted_ordinals = nullptr;
+        size_t document_count = 0;
     };
 
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
+    // Тексты документов и байты термов; после удаления документа его текст остаётся в арене.
+    TextArena text_arena_;
+    TermDictionary dictionary_;
+    std::vector<std::vector<Posting>> postings_;    // индекс - идентификатор терма
+    mutable std::deque<TermStatistics> term_statistics_;    // индекс - идентификатор терма
+    // Растёт при добавлении и удалении документов и при очистке списков словопозиций,
+    // по ней устаревают IDF и разрешённые термы PreparedQuery.
+    uint64_t index_version_ = 1;
+    // Растёт при добавлении и удалении документов и при смене статуса, по ней
+    // устаревают записи кэша выдачи.
+    uint64_t result_cache_version_ = 1;
+    std::vector<std::vector<TermFrequency>> document_terms_;    // индекс - порядковый номер
+    DocumentColumns documents_;
+    // Идентификаторы документов по возрастанию и их порядковые номера. Удалённые
+    // документы остаются в списке до очистки словопозиций, их номера отмечены в
+    // removed_bits_. Идентификаторы обычно растут, тогда добавление - дописывание в
+    // конец; меньший идентификатор попадает в короткий отсортированный список
+    // вставок, который сливается с основным, когда разрастётся.
+    std::vector<int> sorted_ids_;
+    std::vector<uint32_t> sorted_ordinals_;
+    std::vector<int> inserted_ids_;
+    std::vector<uint32_t> inserted_ordinals_;
+    size_t removed_id_count_ = 0;    // удалённых в sorted_ids_
+    // Удалённые документы, словопозиции которых ещё не вычищены: бит по порядковому
+    // номеру (слов хватает на все номера) и список номеров для очистки.
+    std::vector<uint64_t> removed_bits_;
+    std::vector<uint32_t> pending_removals_;
+    MappedIndex mapped_;
+    std::unique_ptr<QueryResultCache> result_cache_;    // не задан, если кэш выключен
+
+    // Номер экземпляра, которым PreparedQuery отличает свой сервер от другого, даже
+    // созданного по тому же адресу. Сервер после перемещения и сервер, из которого
+    // переместили, получают новые номера.
+    class InstanceId {
+    public:
+        InstanceId()
+            : value_(Next()) {
+        }
+
+        InstanceId(const InstanceId&) = delete;
+        InstanceId& operator=(const InstanceId&) = delete;
+
+        InstanceId(InstanceId&& other) noexcept
+            : value_(Next()) {
+            other.value_ = Next();
+        }
+
+        uint64_t Get() const {
+            return value_;
+        }
+
+    private:
+        uint64_t value_;
+
+        static uint64_t Next() {
+            static std::atomic<uint64_t> next_value{ 1 };
+            return next_value.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    InstanceId instance_id_;
+
+    // Очистка запускается, когда отмеченных удалёнными не меньше этого числа
+    // и не меньше восьмой части живых документов.
+    static constexpr size_t MIN_PURGE_BATCH_SIZE = 1 << 10;
+    // Вставки сливаются с основным списком, когда их не меньше этого числа
+    // и не меньше 1/64 основного списка.
+    static constexpr size_t MIN_MERGED_INSERT_COUNT = 1 << 10;
+
+    void AttachSnapshot(std::unique_ptr<const IndexSnapshot> snapshot);
+
+    // Пишет разделы сжатого формата по спискам postings, разбитым смещениями posting_offsets.
+    static void WriteCompressedPostings(SnapshotWriter& writer, const std::vector<uint64_t>& posting_offsets,
+        const std::vector<Posting>& postings);
+
+    // Индекс части пакета AddDocuments с локальными идентификаторами термов.
+    struct PartialIndex {
+        size_t first_document = 0;
+        size_t last_document = 0;
+        std::vector<std::string_view> terms;
+        std::unordered_map<std::string_view, uint32_t> term_ids;
+        std::vector<std::vector<Posting>> postings;
+        std::vector<std::vector<TermFrequency>> document_terms;
+        std::vector<uint32_t> global_term_ids;
+        // Первая ошибка разбора части: исключение нельзя выпускать из параллельного алгоритма.
+        size_t error_document = std::numeric_limits<size_t>::max();
+        std::string error;
+    };
+
+    // Размер части пакета: несколько частей на поток выравнивают нагрузку.
+    static constexpr size_t MIN_BATCH_PART_SIZE = 256;
+
+    void BuildPartialIndex(const std::vector<DocumentInput>& documents, uint32_t first_ordinal, PartialIndex& partial) const;
+
+    template <typename ExecutionPolicy>
+    void AddDocumentBatch(ExecutionPolicy&& policy, const std::vector<DocumentInput>& documents);
+
+    // Бросает logic_error для сервера, открытого из снимка.
+    void CheckWritable() const;
 
     bool IsStopWord(std::string_view word) const;
 
@@ -105,6 +473,9 @@ private:
 
     QueryWord ParseQueryWord(std::string_view text) const;
 
+    // Разбивает запрос на слова; управляющие символы бросают invalid_argument.
+    static std::vector<std::string_view> SplitIntoQueryWords(std::string_view text);
+
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
@@ -116,12 +487,303 @@ private:
     Query PushPlusMinusWords(const std::vector<std::string_view>& data) const;
 
     // Existence required
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    double ComputeWordInverseDocumentFreq(uint32_t term_id) const;
 
-    template <typename DocumentPredicate, typename ExecutionPloicy>
-    std::vector<Document> FindAllDocuments(ExecutionPloicy&& policy, const Query& query, DocumentPredicate document_predicate) const;
+    // IDF из кэша терма. Запросы могут вызывать метод параллельно: значение
+    // публикуется раньше версии, поэтому прочитавший актуальную версию видит
+    // и посчитанное для неё значение.
+    double GetInverseDocumentFreq(uint32_t term_id) const;
+
+    // Доступ к индексу одинаков для построенного в памяти и открытого из снимка сервера.
+    PostingList GetTermPostings(uint32_t term_id) const;
+    double GetMaxTermFreq(uint32_t term_id) const;
+    size_t GetDocumentFreq(uint32_t term_id) const;
+    DocumentColumnsView GetDocumentColumns() const;
+    std::vector<TermFrequency> GetDocumentTerms(uint32_t ordinal) const;
+    IteratorRange<const int*> GetSortedIds() const;
+
+    // Возвращает пустой список, если терм не встречается в индексе.
+    PostingList GetPostings(std::string_view word) const;
+
+    static bool IsPostingBefore(const Posting& posting, uint32_t ordinal);
+    static bool IsBlockBefore(const PostingBlock& block, uint32_t ordinal);
+
+    // Первая словопозиция (для сжатого списка - первый блок) с номером не меньше ordinal.
+    static PostingCursor SeekPosting(const PostingList& postings, uint32_t ordinal);
+
+    // Словопозиции списка из [window_begin, window_end) начиная с курсора; курсор
+    // переходит к window_end. Сжатые блоки распаковываются в buffer, блок на границе
+    // окон распаковывается в обоих.
+    PostingRange ReadWindowPostings(const PostingList& postings, PostingCursor& cursor, uint32_t window_begin, uint32_t window_end,
+        std::vector<Posting>& buffer) const;
+
+    void DecodeBlock(const PostingBlock& block, Posting* postings) const;
+
+    bool FindPosting(const PostingList& postings, uint32_t ordinal, Posting& result) const;
+
+    bool IsRemovedOrdinal(uint32_t ordinal) const;
+
+    template <typename ExecutionPolicy>
+    void RemoveDocumentBatch(ExecutionPolicy&& policy, const std::vector<int>& document_ids);
+
+    template <typename ExecutionPolicy>
+    void PurgePostings(ExecutionPolicy&& policy);
+
+    static uint32_t CountTrailingZeros(uint64_t bits);
+
+    // Возвращает NO_ORDINAL для неизвестного идентификатора.
+    uint32_t FindOrdinal(int document_id) const;
+    // Бросает out_of_range для неизвестного идентификатора.
+    uint32_t GetOrdinal(int document_id) const;
+
+    // Добавляет идентификатор нового документа: удалённый с тем же идентификатором
+    // заменяется на месте, больший последнего дописывается, иначе он идёт во вставки.
+    void InsertSortedId(int document_id, uint32_t ordinal);
+
+    // Сливает с основным списком отсортированные пары (идентификатор, номер) и вставки.
+    void MergeSortedIds(std::vector<std::pair<int, uint32_t>> ids);
+
+    // Итератор в начале обоих списков, без пропуска удалённых.
+    DocumentIdIterator MakeDocumentIdIterator() const;
+
+    // Запрос с разрешёнными термами: IDF считается один раз на запрос, а не на задачу.
+    struct ResolvedQuery {
+        struct PlusTerm {
+            PostingList postings;
+            double inverse_document_freq;
+            double max_relevance;    // оценка сверху вклада терма в релевантность документа
+        };
+
+        // Плюс-термы упорядочены по убыванию max_relevance, в этом же порядке
+        // складываются вклады, поэтому отсечение не меняет итоговые суммы.
+        std::vector<PlusTerm> plus_terms;
+        // max_relevance_suffix[i] - сумма max_relevance термов начиная с i-го.
+        std::vector<double> max_relevance_suffix;
+        std::vector<PostingList> minus_postings;
+        DocumentColumnsView documents;
+        // Биты удалённых, но не вычищенных документов; не задан, если таких нет.
+        const uint64_t* removed_bits = nullptr;
+
+        // Короткие списки минус-слов отмечаются в накопителе до подсчёта, и исключённые
+        // документы не считаются вовсе. Если минус-списки длиннее плюс-списков, их
+        // дешевле проверить поиском только для набравших релевантность документов.
+        bool exclude_before_scoring = true;
+    };
+
+    // IDF берётся из corpus, если она задана, иначе из статистики сервера.
+    ResolvedQuery ResolveQuery(const Query& query, const CorpusStatistics* corpus) const;
+
+    // Разрешение подготовленного запроса годится, если он подготовлен этим сервером
+    // и индекс с тех пор не менялся; иначе термы разрешаются заново.
+    bool IsResolutionCurrent(const PreparedQuery& query) const;
+
+    static size_t CountPostings(const ResolvedQuery& query);
+
+    static constexpr uint32_t MINUS_WORD = std::numeric_limits<uint32_t>::max();
+
+    // Термы запроса по возрастанию идентификатора для слияния с прямым индексом и
+    // таблица для проверки термов документа, который короче запроса.
+    struct MatchPlan {
+        std::vector<std::pair<uint32_t, uint32_t>> plus_terms;    // терм и номер слова в plus_words
+        std::vector<uint32_t> minus_term_ids;
+        std::unordered_map<uint32_t, uint32_t> word_indices;      // терм -> номер плюс-слова или MINUS_WORD
+    };
+
+    MatchPlan PlanMatch(const Query& query) const;
+
+    // Проверка в параллельных задачах окупается, только если операций (поисков в
+    // таблице или шагов бинарного поиска) не меньше этого числа и ядер больше одного.
+    static constexpr size_t MIN_PARALLEL_MATCH_WORK = 1 << 15;
+    // Термов документа на задачу при параллельной проверке по таблице.
+    static constexpr size_t MATCH_CHUNK_SIZE = 1 << 13;
+    // Во столько шагов бинарного поиска обходится поиск в таблице запроса.
+    static constexpr size_t HASHED_LOOKUP_COST = 4;
+    // Короче этого запрос сортируется последовательно и при параллельной политике.
+    static constexpr size_t MIN_PARALLEL_QUERY_WORD_COUNT = 1 << 12;
+
+    // Ищет термы запроса в прямом индексе документа. При parallel термы
+    // проверяются параллельно, если работы достаточно.
+    MatchResult MatchOrdinal(const Query& query, const MatchPlan& plan, uint32_t ordinal, bool parallel = false) const;
+
+    static uint32_t GetTermId(const TermFrequency& item);
+    static uint32_t GetTermId(uint32_t term_id);
+
+    // Номера найденных в [first, last) плюс-слов; пусто, если найдено минус-слово.
+    // Термы диапазона отсортированы по возрастанию. Выбирается дешёвый способ:
+    // каждый терм документа ищется в таблице запроса или каждый терм запроса -
+    // бинарным поиском в документе.
+    template <typename TermIterator>
+    static std::vector<uint32_t> MatchTermRange(const MatchPlan& plan, TermIterator first, TermIterator last, bool parallel);
+
+    template <typename ExecutionPolicy>
+    std::vector<MatchResult> MatchQueryDocuments(ExecutionPolicy&& policy, const Query& query, const MatchPlan& plan,
+        const std::vector<int>& document_ids) const;
+
+    // Выдача по статусу через кэш, если он включён. resolved может быть не задан.
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindDocumentsWithStatus(ExecutionPolicy&& policy, const Query& query, const ResolvedQuery* resolved,
+        DocumentStatus status, size_t result_count, Deadline deadline = NO_DEADLINE) const;
+
+    // Позиции в списках словопозиций термов запроса: первая словопозиция не раньше начала окна.
+    struct PostingCursors {
+        std::vector<PostingCursor> plus;
+        std::vector<PostingCursor> minus;
+    };
+
+    static PostingCursors SeekPostings(const ResolvedQuery& query, uint32_t ordinal);
+
+    // Первая словопозиция из [first, last) с номером не меньше ordinal. Поиск
+    // экспоненциальный, поэтому короткие переходы стоят дёшево.
+    static const Posting* SkipTo(const Posting* first, const Posting* last, uint32_t ordinal);
+
+    // Подсчёт релевантности идёт по окнам порядковых номеров документов. Каждое окно
+    // обрабатывается целиком одним потоком в его собственном плотном накопителе,
+    // поэтому параллельным задачам не нужны ни блокировки, ни слияние сумм.
+    // Первое окно маленькое, чтобы быстрее получить порог отсечения для остальных.
+    static constexpr uint32_t FIRST_SCORE_WINDOW_SIZE = 1 << 10;
+    static constexpr uint32_t SCORE_WINDOW_SIZE = 1 << 14;
+    static constexpr uint32_t MIN_PARALLEL_SCORE_WINDOW_SIZE = 1 << 12;
+
+    enum class SlotState : uint8_t {
+        EMPTY,
+        SCORED,
+        EXCLUDED,
+    };
+
+    struct ScoreAccumulator {
+        std::vector<double> relevance;
+        std::vector<SlotState> states;
+        std::vector<uint32_t> hits;          // затронутые ячейки, по ним накопитель и очищается
+        std::vector<uint32_t> candidates;    // ячейки, ещё способные попасть в выдачу
+        std::vector<std::vector<Posting>> window_postings;    // распакованные блоки, по буферу на терм
+        std::vector<PostingRange> plus_postings;     // словопозиции окна по термам запроса
+        std::vector<PostingRange> minus_postings;
+    };
+
+    // Накопитель переиспользуется между запросами одного потока.
+    static ScoreAccumulator& GetThreadAccumulator();
+
+    // Считает документы окна и продвигает курсоры к его концу. Документы, которые даже
+    // с наибольшим возможным вкладом оставшихся термов не дотягивают до threshold,
+    // отбрасываются без подсчёта (MaxScore): термы, сумма оценок которых ниже порога,
+    // не порождают новых кандидатов, а лишь уточняют релевантность уже найденных.
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    void ScoreWindow(const ResolvedQuery& query, PostingCursors& cursors, uint32_t window_begin, uint32_t window_end,
+        double threshold, DocumentPredicate& document_predicate, TopDocuments& top_documents) const;
+
+    static void RaiseThreshold(std::atomic<double>& shared_threshold, double threshold);
+
+    static bool IsExpired(Deadline deadline);
+
+    // Вызывает function для каждого окна: задачами пула для WorkStealingPool::ExecutionPolicy,
+    // иначе стандартным алгоритмом с политикой policy.
+    template <typename ExecutionPolicy, typename Function>
+    static void ForEachWindow(ExecutionPolicy&& policy, std::vector<uint32_t>& windows, Function function);
+
+    // Отбирает result_count лучших документов; при параллельной политике каждое окно
+    // ведёт свою кучу, и кучи сливаются в конце.
+    template <typename DocumentPredicate, typename ExecutionPloicy>
+    std::vector<Document> FindBestDocuments(ExecutionPloicy&& policy, const ResolvedQuery& resolved_query, DocumentPredicate document_predicate,
+        size_t result_count, Deadline deadline = NO_DEADLINE) const;
+};
+
+/**
+	* Обходит идентификаторы живых документов по возрастанию: сливает основной
+	* список со вставками и пропускает удалённые, ещё не вычищенные документы.
+	**/
+class SearchServer::DocumentIdIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int*;
+    using reference = const int&;
+
+    DocumentIdIterator() = default;
+
+    reference operator*() const {
+        return IsSortedCurrent() ? *sorted_ids_ : *inserted_ids_;
+    }
+
+    pointer operator->() const {
+        return &**this;
+    }
+
+    DocumentIdIterator& operator++() {
+        if (IsSortedCurrent()) {
+            ++sorted_ids_;
+            ++sorted_ordinals_;
+            SkipRemoved();
+        }
+        else {
+            ++inserted_ids_;
+            ++inserted_ordinals_;
+        }
+        return *this;
+    }
+
+    DocumentIdIterator operator++(int) {
+        DocumentIdIterator result = *this;
+        ++*this;
+        return result;
+    }
+
+    bool operator==(const DocumentIdIterator& other) const {
+        return sorted_ids_ == other.sorted_ids_ && inserted_ids_ == other.inserted_ids_;
+    }
+
+    bool operator!=(const DocumentIdIterator& other) const {
+        return !(*this == other);
+    }
+
+private:
+    friend class SearchServer;
+
+    const int* sorted_ids_ = nullptr;
+    const int* sorted_end_ = nullptr;
+    const uint32_t* sorted_ordinals_ = nullptr;
+    const int* inserted_ids_ = nullptr;
+    const int* inserted_end_ = nullptr;
+    const uint32_t* inserted_ordinals_ = nullptr;
+    const uint64_t* removed_bits_ = nullptr;    // nullptr, если удалённых в основном списке нет
+
+    bool IsSortedCurrent() const {
+        return sorted_ids_ != sorted_end_ && (inserted_ids_ == inserted_end_ || *sorted_ids_ < *inserted_ids_);
+    }
+
+    void SkipRemoved() {
+        if (removed_bits_ == nullptr) {
+            return;
+        }
+        while (sorted_ids_ != sorted_end_ && ((removed_bits_[*sorted_ordinals_ / 64] >> (*sorted_ordinals_ % 64)) & 1)) {
+            ++sorted_ids_;
+            ++sorted_ordinals_;
+        }
+    }
+
+    uint32_t GetOrdinal() const {
+        return IsSortedCurrent() ? *sorted_ordinals_ : *inserted_ordinals_;
+    }
+};
+
+/**
+	* Разобранный запрос с разрешёнными термами: списками словопозиций и IDF.
+	* Выполняется сколько угодно раз без повторного разбора; после изменения
+	* индекса или на другом сервере термы разрешаются заново по сохранённым словам.
+	* Текст запроса копируется, исходная строка может быть удалена.
+	**/
+class SearchServer::PreparedQuery {
+private:
+    friend class SearchServer;
+
+    PreparedQuery() = default;
+
+    std::unique_ptr<const std::string> text_;    // слова query_ указывают сюда, адрес не меняется при перемещении
+    Query query_;
+    uint64_t server_id_ = 0;
+    uint64_t index_version_ = 0;
+    ResolvedQuery resolved_;
+    std::optional<MatchPlan> match_plan_;    // не задан для PrepareSearchQuery
 };
 
 template <typename StringContainer>
@@ -136,40 +798,85 @@ SearchServer::SearchServer(const StringContainer& stop_words)
 }
 
 template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    using namespace std::string_literals;
-
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+    size_t result_count) const {
     const auto query = ParseQuery(raw_query);
 
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+    return FindBestDocuments(policy, ResolveQuery(query, nullptr), document_predicate, result_count);
+}
 
-    sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, const CorpusStatistics& corpus,
+    DocumentPredicate document_predicate, size_t result_count) const {
+    const auto query = ParseQuery(raw_query);
 
-        if (std::abs(lhs.relevance - rhs.relevance) < SMALL_RANGE_FOR_COMPARE) {
-            return lhs.rating > rhs.rating;
-        }
-        else {
-            return lhs.relevance > rhs.relevance;
-        }
-        });
+    return FindBestDocuments(policy, ResolveQuery(query, &corpus), document_predicate, result_count);
+}
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentPredicate document_predicate,
+    size_t result_count) const {
+    if (IsResolutionCurrent(query)) {
+        return FindBestDocuments(policy, query.resolved_, document_predicate, result_count);
     }
+    return FindBestDocuments(policy, ResolveQuery(query.query_, nullptr), document_predicate, result_count);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate,
+    size_t result_count) const {
+    return FindTopDocuments(std::execution::seq, query, document_predicate, result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentStatus status,
+    size_t result_count) const {
+    return FindDocumentsWithStatus(policy, query.query_, IsResolutionCurrent(query) ? &query.resolved_ : nullptr, status, result_count);
+}
 
-    return matched_documents;
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentStatus status,
+    size_t result_count, Deadline deadline) const {
+    return FindDocumentsWithStatus(policy, query.query_, IsResolutionCurrent(query) ? &query.resolved_ : nullptr, status, result_count,
+        deadline);
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+    size_t result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+    size_t result_count) const {
+    const auto query = ParseQuery(raw_query);
+
+    return FindDocumentsWithStatus(policy, query, nullptr, status, result_count);
 }
 
 template <typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
+std::vector<Document> SearchServer::FindDocumentsWithStatus(ExecutionPolicy&& policy, const Query& query, const ResolvedQuery* resolved,
+    DocumentStatus status, size_t result_count, Deadline deadline) const {
+    const auto document_predicate = [status](int, DocumentStatus document_status, int) {
         return document_status == status;
-        });
+    };
+    const auto find_documents = [&] {
+        return resolved != nullptr
+            ? FindBestDocuments(policy, *resolved, document_predicate, result_count, deadline)
+            : FindBestDocuments(policy, ResolveQuery(query, nullptr), document_predicate, result_count, deadline);
+    };
+    if (!result_cache_) {
+        return find_documents();
+    }
+
+    std::string key = QueryResultCache::MakeKey(query.plus_words, query.minus_words, status, result_count);
+    std::vector<Document> result;
+    if (!result_cache_->Find(key, result_cache_version_, result)) {
+        result = find_documents();
+        result_cache_->Insert(std::move(key), result_cache_version_, result);
+    }
+    return result;
 }
 
 template <typename ExecutionPolicy>
@@ -177,58 +884,305 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, s
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(8);
-    std::map<int, double> tmp_map;
+template <typename DocumentPredicate>
+void SearchServer::ScoreWindow(const ResolvedQuery& query, PostingCursors& cursors, uint32_t window_begin, uint32_t window_end,
+    double threshold, DocumentPredicate& document_predicate, TopDocuments& top_documents) const {
+    auto& [relevance, states, hits, candidates, window_postings, plus_postings, minus_postings] = GetThreadAccumulator();
+    const auto& plus_terms = query.plus_terms;
+    StageTimer timer;
 
-    std::for_each(
-        policy,
-        query.plus_words.begin(),
-        query.plus_words.end(),
-        [this, &document_to_relevance, &document_predicate, &tmp_map](std::string_view word) {
-            if (word_to_document_freqs_.count(word)) {
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                    const auto& document_data = documents_.at(document_id);
-                    if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                        document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                    }
+    if (window_postings.size() < plus_terms.size() + query.minus_postings.size()) {
+        window_postings.resize(plus_terms.size() + query.minus_postings.size());
+    }
+    plus_postings.clear();
+    for (size_t i = 0; i < plus_terms.size(); ++i) {
+        plus_postings.push_back(ReadWindowPostings(plus_terms[i].postings, cursors.plus[i], window_begin, window_end,
+            window_postings[i]));
+    }
+    minus_postings.clear();
+    for (size_t i = 0; i < query.minus_postings.size(); ++i) {
+        minus_postings.push_back(ReadWindowPostings(query.minus_postings[i], cursors.minus[i], window_begin, window_end,
+            window_postings[plus_terms.size() + i]));
+    }
+    timer.Mark(ProfileStage::POSTING_TRAVERSAL);
+
+    if (query.removed_bits != nullptr) {
+        // Словопозиции удалённых документов ещё в списках: их ячейки исключаются до подсчёта.
+        for (uint32_t word = window_begin / 64; word * 64 < window_end; ++word) {
+            for (uint64_t bits = query.removed_bits[word]; bits != 0; bits &= bits - 1) {
+                const uint32_t ordinal = word * 64 + CountTrailingZeros(bits);
+                if (ordinal >= window_begin && ordinal < window_end) {
+                    states[ordinal - window_begin] = SlotState::EXCLUDED;
+                    hits.push_back(ordinal - window_begin);
                 }
             }
         }
-    );
+    }
 
-    std::for_each(
-        policy,
-        query.minus_words.begin(),
-        query.minus_words.end(),
-        [this, &document_predicate, &document_to_relevance](std::string_view word) {
-            if (word_to_document_freqs_.count(word)) {
-                for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                    document_to_relevance.erase(document_id);
+    if (query.exclude_before_scoring) {
+        for (const PostingRange postings : minus_postings) {
+            for (const Posting& posting : postings) {
+                const uint32_t slot = posting.ordinal - window_begin;
+                if (states[slot] == SlotState::EMPTY) {
+                    states[slot] = SlotState::EXCLUDED;
+                    hits.push_back(slot);
                 }
             }
         }
-    );
+    }
+
+    timer.Mark(ProfileStage::MINUS_FILTER);
 
-    tmp_map = document_to_relevance.BuildOrdinaryMap();
+    size_t essential_count = plus_terms.size();
+    while (essential_count > 0 && query.max_relevance_suffix[essential_count - 1] < threshold) {
+        --essential_count;
+    }
 
-    std::vector<Document> matched_documents(tmp_map.size());
-    std::transform(
+    for (size_t i = 0; i < essential_count; ++i) {
+        const double inverse_document_freq = plus_terms[i].inverse_document_freq;
+        for (const Posting& posting : plus_postings[i]) {
+            const uint32_t slot = posting.ordinal - window_begin;
+            const SlotState state = states[slot];
+            if (state == SlotState::SCORED) {
+                relevance[slot] += posting.term_freq * inverse_document_freq;
+            }
+            else if (state == SlotState::EMPTY) {
+                states[slot] = SlotState::SCORED;
+                relevance[slot] = posting.term_freq * inverse_document_freq;
+                hits.push_back(slot);
+            }
+        }
+    }
+
+    timer.Mark(ProfileStage::POSTING_TRAVERSAL);
+
+    candidates.clear();
+    for (const uint32_t slot : hits) {
+        if (states[slot] == SlotState::SCORED) {
+            candidates.push_back(slot);
+        }
+    }
+    bool candidates_sorted = false;
+
+    if (!query.exclude_before_scoring) {
+        std::sort(candidates.begin(), candidates.end());
+        candidates_sorted = true;
+        for (const PostingRange postings : minus_postings) {
+            const Posting* it = postings.begin();
+            for (const uint32_t slot : candidates) {
+                it = SkipTo(it, postings.end(), window_begin + slot);
+                if (it != postings.end() && it->ordinal == window_begin + slot) {
+                    states[slot] = SlotState::EXCLUDED;
+                }
+            }
+        }
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&states](uint32_t slot) {
+            return states[slot] == SlotState::EXCLUDED;
+            }), candidates.end());
+    }
+    timer.Mark(ProfileStage::MINUS_FILTER);
+
+    for (size_t i = essential_count; i < plus_terms.size(); ++i) {
+        const double inverse_document_freq = plus_terms[i].inverse_document_freq;
+        const Posting* first = plus_postings[i].begin();
+        const Posting* window_last = plus_postings[i].end();
+
+        // Немногих кандидатов дешевле искать в списке, иначе список просматривается целиком.
+        if (candidates.size() * 4 < static_cast<size_t>(window_last - first)) {
+            // Кандидат, которому не хватит даже всех оставшихся термов, исключается.
+            const double remaining_relevance = query.max_relevance_suffix[i];
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](uint32_t slot) {
+                if (relevance[slot] + remaining_relevance < threshold) {
+                    states[slot] = SlotState::EXCLUDED;
+                    return true;
+                }
+                return false;
+                }), candidates.end());
+
+            if (!candidates_sorted) {
+                std::sort(candidates.begin(), candidates.end());
+                candidates_sorted = true;
+            }
+            for (const uint32_t slot : candidates) {
+                first = SkipTo(first, window_last, window_begin + slot);
+                if (first == window_last) {
+                    break;
+                }
+                if (first->ordinal == window_begin + slot) {
+                    relevance[slot] += first->term_freq * inverse_document_freq;
+                }
+            }
+        }
+        else {
+            for (; first != window_last; ++first) {
+                const uint32_t slot = first->ordinal - window_begin;
+                if (states[slot] == SlotState::SCORED) {
+                    relevance[slot] += first->term_freq * inverse_document_freq;
+                }
+            }
+        }
+    }
+
+    timer.Mark(ProfileStage::POSTING_TRAVERSAL);
+
+    const DocumentColumnsView& documents = query.documents;
+    for (const uint32_t slot : candidates) {
+        const uint32_t ordinal = window_begin + slot;
+        if (relevance[slot] >= threshold
+            && document_predicate(documents.ids[ordinal], documents.statuses[ordinal], documents.ratings[ordinal])) {
+            top_documents.Push(Document{ documents.ids[ordinal], relevance[slot], documents.ratings[ordinal] });
+        }
+    }
+    timer.Mark(ProfileStage::TOP_K);
+
+    for (const uint32_t slot : hits) {
+        states[slot] = SlotState::EMPTY;
+    }
+    hits.clear();
+}
+
+template <typename ExecutionPolicy, typename Function>
+void SearchServer::ForEachWindow(ExecutionPolicy&& policy, std::vector<uint32_t>& windows, Function function) {
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, WorkStealingPool::ExecutionPolicy>) {
+        policy.pool.ForEach(windows.begin(), windows.end(), function);
+    }
+    else {
+        std::for_each(policy, windows.begin(), windows.end(), function);
+    }
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindBestDocuments(ExecutionPolicy&& policy, const ResolvedQuery& resolved_query, DocumentPredicate document_predicate,
+    size_t result_count, Deadline deadline) const {
+    using namespace std::string_literals;
+
+    const uint32_t ordinal_end = resolved_query.documents.ordinal_count;
+
+    TopDocuments top_documents(result_count);
+    if (resolved_query.plus_terms.empty() || result_count == 0) {
+        return top_documents.Extract();
+    }
+
+    uint32_t window_size = SCORE_WINDOW_SIZE;
+    if constexpr (!std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        // Несколько окон на поток, чтобы выровнять нагрузку между ними.
+        const uint32_t task_count = std::max(1u, std::thread::hardware_concurrency()) * 4;
+        window_size = std::clamp((ordinal_end + task_count - 1) / task_count,
+            MIN_PARALLEL_SCORE_WINDOW_SIZE, SCORE_WINDOW_SIZE);
+    }
+    const uint32_t window_count = (ordinal_end + window_size - 1) / window_size;
+
+    if (window_count <= 1 || std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        PostingCursors cursors = SeekPostings(resolved_query, 0);
+        uint32_t window_begin = 0;
+        window_size = FIRST_SCORE_WINDOW_SIZE;
+        while (window_begin < ordinal_end) {
+            if (IsExpired(deadline)) {
+                throw DeadlineExceeded("Query deadline exceeded"s);
+            }
+            const uint32_t window_end = std::min(ordinal_end, window_begin + window_size);
+            ScoreWindow(resolved_query, cursors, window_begin, window_end,
+                top_documents.GetRelevanceThreshold(), document_predicate, top_documents);
+            window_begin = window_end;
+            window_size = SCORE_WINDOW_SIZE;
+        }
+        ScopedStageTimer timer(ProfileStage::RESULT_BUILD);
+        return top_documents.Extract();
+    }
+
+    std::vector<TopDocuments> window_top_documents(window_count, TopDocuments(result_count));
+    std::vector<uint32_t> windows(window_count);
+    std::iota(windows.begin(), windows.end(), 0u);
+
+    // Порог любого окна годится и для остальных: его K документов уже лучше отсечённых.
+    std::atomic<double> shared_threshold(-std::numeric_limits<double>::infinity());
+    std::atomic<bool> expired(false);
+
+    ForEachWindow(
         policy,
-        tmp_map.begin(),
-        tmp_map.end(),
-        matched_documents.begin(),
-        [this](const auto& item) {
-            return Document{ item.first, item.second, documents_.at(item.first).rating };
+        windows,
+        [&](uint32_t window) {
+            if (expired.load(std::memory_order_relaxed) || IsExpired(deadline)) {
+                expired.store(true, std::memory_order_relaxed);
+                return;
+            }
+            // Предикат копируется, чтобы задачи не делили его состояние.
+            DocumentPredicate window_predicate = document_predicate;
+            TopDocuments& window_top = window_top_documents[window];
+            const uint32_t window_begin = window * window_size;
+            PostingCursors cursors = SeekPostings(resolved_query, window_begin);
+            ScoreWindow(resolved_query, cursors, window_begin, std::min(ordinal_end, window_begin + window_size),
+                shared_threshold.load(std::memory_order_relaxed), window_predicate, window_top);
+            RaiseThreshold(shared_threshold, window_top.GetRelevanceThreshold());
         }
     );
+    if (expired.load()) {
+        throw DeadlineExceeded("Query deadline exceeded"s);
+    }
+
+    StageTimer timer;
+    for (const auto& window_top : window_top_documents) {
+        top_documents.Merge(window_top);
+    }
+    timer.Mark(ProfileStage::TOP_K);
 
-    return matched_documents;
+    ScopedStageTimer result_timer(ProfileStage::RESULT_BUILD);
+    return top_documents.Extract();
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const
+{
+    const uint32_t ordinal = GetOrdinal(document_id);
+
+    const auto query = ParseQuery(policy, raw_query);
+
+    constexpr bool parallel = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>;
+    return MatchOrdinal(query, PlanMatch(query), ordinal, parallel);
+}
+
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&&, const PreparedQuery& query, int document_id) const
+{
+    const uint32_t ordinal = GetOrdinal(document_id);
+
+    constexpr bool parallel = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>;
+    if (IsResolutionCurrent(query) && query.match_plan_) {
+        return MatchOrdinal(query.query_, *query.match_plan_, ordinal, parallel);
+    }
+    return MatchOrdinal(query.query_, PlanMatch(query.query_), ordinal, parallel);
+}
+
+template <typename ExecutionPolicy>
+std::vector<SearchServer::MatchResult> SearchServer::MatchDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+    const std::vector<int>& document_ids) const {
+    const auto query = ParseQuery(raw_query);
+
+    return MatchQueryDocuments(policy, query, PlanMatch(query), document_ids);
+}
+
+template <typename ExecutionPolicy>
+std::vector<SearchServer::MatchResult> SearchServer::MatchDocuments(ExecutionPolicy&& policy, const PreparedQuery& query,
+    const std::vector<int>& document_ids) const {
+    if (IsResolutionCurrent(query) && query.match_plan_) {
+        return MatchQueryDocuments(policy, query.query_, *query.match_plan_, document_ids);
+    }
+    return MatchQueryDocuments(policy, query.query_, PlanMatch(query.query_), document_ids);
+}
+
+template <typename ExecutionPolicy>
+std::vector<SearchServer::MatchResult> SearchServer::MatchQueryDocuments(ExecutionPolicy&& policy, const Query& query,
+    const MatchPlan& plan, const std::vector<int>& document_ids) const {
+    std::vector<uint32_t> ordinals;
+    ordinals.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        ordinals.push_back(GetOrdinal(document_id));
+    }
+
+    std::vector<MatchResult> result(ordinals.size());
+    std::transform(policy, ordinals.begin(), ordinals.end(), result.begin(), [&](uint32_t ordinal) {
+        return MatchOrdinal(query, plan, ordinal);
+        });
+    return result;
 }
+
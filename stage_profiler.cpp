@@ -0,0 +1,212 @@
+#include "stage_profiler.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct StageCounters {
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> total_nanoseconds{ 0 };
+    std::atomic<uint64_t> max_nanoseconds{ 0 };
+    std::array<std::atomic<uint64_t>, StageProfiler::BUCKET_COUNT> histogram{};
+};
+
+// Счётчики одного потока. Пишет только владелец, поэтому ему хватает load и store;
+// атомарность нужна лишь для чтения из других потоков.
+struct ThreadCounters {
+    std::atomic<uint64_t> generation{ 0 };    // поколение Reset, к которому относятся счётчики
+    std::array<StageCounters, StageProfiler::STAGE_COUNT> stages;
+};
+
+void Increase(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void Clear(ThreadCounters& counters) {
+    for (StageCounters& stage : counters.stages) {
+        stage.count.store(0, std::memory_order_relaxed);
+        stage.total_nanoseconds.store(0, std::memory_order_relaxed);
+        stage.max_nanoseconds.store(0, std::memory_order_relaxed);
+        for (auto& bucket : stage.histogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Accumulate(const ThreadCounters& counters, StageProfiler::Statistics& statistics) {
+    for (size_t i = 0; i < StageProfiler::STAGE_COUNT; ++i) {
+        const StageCounters& stage = counters.stages[i];
+        StageProfiler::StageStatistics& result = statistics[i];
+        result.count += stage.count.load(std::memory_order_relaxed);
+        result.total_nanoseconds += stage.total_nanoseconds.load(std::memory_order_relaxed);
+        result.max_nanoseconds = std::max(result.max_nanoseconds, stage.max_nanoseconds.load(std::memory_order_relaxed));
+        for (size_t bucket = 0; bucket < StageProfiler::BUCKET_COUNT; ++bucket) {
+            result.histogram[bucket] += stage.histogram[bucket].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Счётчики живых потоков и сумма счётчиков завершившихся.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadCounters>> threads;
+    StageProfiler::Statistics finished{};
+    std::atomic<uint64_t> generation{ 0 };
+};
+
+// Не разрушается: потоки статических пулов завершаются позже статических объектов этого файла.
+Registry& GetRegistry() {
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+// Регистрирует счётчики потока при первом замере; при завершении потока переносит их в общую сумму.
+class ThreadRegistration {
+public:
+    ThreadRegistration()
+        : counters_(std::make_shared<ThreadCounters>())
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        counters_->generation.store(registry.generation.load());
+        registry.threads.push_back(counters_);
+    }
+
+    ~ThreadRegistration() {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        if (counters_->generation.load() == registry.generation.load()) {
+            Accumulate(*counters_, registry.finished);
+        }
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), counters_));
+    }
+
+    ThreadCounters& GetCounters() {
+        return *counters_;
+    }
+
+private:
+    std::shared_ptr<ThreadCounters> counters_;
+};
+
+} // namespace
+
+uint64_t StageProfiler::StageStatistics::GetPercentile(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += histogram[bucket];
+        if (seen >= rank) {
+            return GetBucketLowerBound(bucket);
+        }
+    }
+    return max_nanoseconds;
+}
+
+void StageProfiler::Record(ProfileStage stage, std::chrono::steady_clock::duration duration) {
+    thread_local ThreadRegistration registration;
+    ThreadCounters& counters = registration.GetCounters();
+
+    // После Reset поток обнуляет свои счётчики сам, чтобы не гоняться с ним за запись.
+    const uint64_t generation = GetRegistry().generation.load(std::memory_order_acquire);
+    if (counters.generation.load(std::memory_order_relaxed) != generation) {
+        Clear(counters);
+        counters.generation.store(generation, std::memory_order_release);
+    }
+
+    const uint64_t nanoseconds = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    StageCounters& counter = counters.stages[static_cast<size_t>(stage)];
+    Increase(counter.count, 1);
+    Increase(counter.total_nanoseconds, nanoseconds);
+    if (nanoseconds > counter.max_nanoseconds.load(std::memory_order_relaxed)) {
+        counter.max_nanoseconds.store(nanoseconds, std::memory_order_relaxed);
+    }
+    Increase(counter.histogram[GetBucket(nanoseconds)], 1);
+}
+
+StageProfiler::Statistics StageProfiler::GetStatistics() {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    Statistics result = registry.finished;
+    const uint64_t generation = registry.generation.load();
+    for (const auto& counters : registry.threads) {
+        // Поток, ещё не заметивший Reset, хранит устаревшие значения.
+        if (counters->generation.load(std::memory_order_acquire) == generation) {
+            Accumulate(*counters, result);
+        }
+    }
+    return result;
+}
+
+void StageProfiler::Dump(std::ostream& out) {
+    const Statistics statistics = GetStatistics();
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const StageStatistics& stage = statistics[i];
+        if (stage.count == 0) {
+            continue;
+        }
+        out << GetStageName(static_cast<ProfileStage>(i))
+            << ": count " << stage.count
+            << ", total " << stage.total_nanoseconds / 1000 << " us"
+            << ", mean " << stage.total_nanoseconds / stage.count << " ns"
+            << ", p50 " << stage.GetPercentile(50) << " ns"
+            << ", p99 " << stage.GetPercentile(99) << " ns"
+            << ", max " << stage.max_nanoseconds << " ns" << std::endl;
+    }
+}
+
+void StageProfiler::Reset() {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.finished = Statistics{};
+    registry.generation.fetch_add(1, std::memory_order_release);
+}
+
+const char* StageProfiler::GetStageName(ProfileStage stage) {
+    switch (stage) {
+    case ProfileStage::PARSE:
+        return "parse";
+    case ProfileStage::IDF:
+        return "idf";
+    case ProfileStage::POSTING_TRAVERSAL:
+        return "posting traversal";
+    case ProfileStage::MINUS_FILTER:
+        return "minus filter";
+    case ProfileStage::TOP_K:
+        return "top-k";
+    case ProfileStage::RESULT_BUILD:
+        return "result build";
+    case ProfileStage::ADD_DOCUMENT:
+        return "add document";
+    case ProfileStage::REMOVE_DOCUMENT:
+        return "remove document";
+    }
+    return "unknown";
+}
+
+size_t StageProfiler::GetBucket(uint64_t nanoseconds) {
+    if (nanoseconds < 16) {
+        return nanoseconds;
+    }
+    size_t exponent = 0;
+    while ((nanoseconds >> exponent) > 1) {
+        ++exponent;
+    }
+    // Три старших бита после ведущей единицы - номер подинтервала.
+    return 16 + (exponent - 4) * 8 + ((nanoseconds >> (exponent - 3)) & 7);
+}
+
+uint64_t StageProfiler::GetBucketLowerBound(size_t bucket) {
+    if (bucket < 16) {
+        return bucket;
+    }
+    const size_t exponent = (bucket - 16) / 8 + 4;
+    return (8 + (bucket - 16) % 8) << (exponent - 3);
+}
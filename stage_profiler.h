@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Замеры включаются флагом сборки -DSEARCH_SERVER_PROFILING. Без него StageTimer
+// и ScopedStageTimer пустые и встраиваются в ничто, а статистика всегда нулевая.
+
+// Этапы, время которых замеряется.
+enum class ProfileStage {
+    PARSE,                // разбор запроса
+    IDF,                  // поиск термов в словаре и расчёт IDF
+    POSTING_TRAVERSAL,    // чтение списков словопозиций и подсчёт релевантности
+    MINUS_FILTER,         // исключение документов с минус-словами и удалённых
+    TOP_K,                // отбор лучших документов окна и слияние куч
+    RESULT_BUILD,         // сборка выдачи из кучи
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT,
+};
+
+/**
+	* Статистика длительностей этапов. Каждый поток пишет в свои счётчики без
+	* атомарных операций чтения-изменения-записи и без блокировок; чтение
+	* суммирует счётчики всех потоков. Длительности хранятся в гистограмме с
+	* логарифмическими интервалами по 8 подинтервалов (как в HdrHistogram):
+	* процентили точны до 12.5%.
+	**/
+class StageProfiler {
+public:
+    static constexpr bool ENABLED =
+#ifdef SEARCH_SERVER_PROFILING
+        true;
+#else
+        false;
+#endif
+
+    static constexpr size_t STAGE_COUNT = 8;
+    static constexpr size_t BUCKET_COUNT = 16 + 60 * 8;
+
+    struct StageStatistics {
+        uint64_t count = 0;
+        uint64_t total_nanoseconds = 0;
+        uint64_t max_nanoseconds = 0;
+        std::array<uint64_t, BUCKET_COUNT> histogram{};
+
+        // Нижняя граница интервала, в который попадает процентиль percentile (0..100).
+        uint64_t GetPercentile(double percentile) const;
+    };
+
+    using Statistics = std::array<StageStatistics, STAGE_COUNT>;    // индекс - ProfileStage
+
+    static void Record(ProfileStage stage, std::chrono::steady_clock::duration duration);
+
+    static Statistics GetStatistics();
+
+    // Печатает этапы, у которых есть замеры: число, сумму, среднее, p50, p99 и максимум.
+    static void Dump(std::ostream& out);
+
+    // Обнуляет статистику всех потоков. Замеры, идущие одновременно, могут потеряться.
+    static void Reset();
+
+    static const char* GetStageName(ProfileStage stage);
+
+    static size_t GetBucket(uint64_t nanoseconds);
+    static uint64_t GetBucketLowerBound(size_t bucket);
+};
+
+#ifdef SEARCH_SERVER_PROFILING
+
+// Делит время между этапами, которые чередуются в одном участке кода: Mark
+// относит к stage время с предыдущей отметки (или с создания).
+class StageTimer {
+public:
+    StageTimer()
+        : last_(std::chrono::steady_clock::now()) {
+    }
+
+    void Mark(ProfileStage stage) {
+        const auto now = std::chrono::steady_clock::now();
+        StageProfiler::Record(stage, now - last_);
+        last_ = now;
+    }
+
+private:
+    std::chrono::steady_clock::time_point last_;
+};
+
+// Замеряет этап от создания до конца области видимости.
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(ProfileStage stage)
+        : stage_(stage) {
+    }
+
+    ~ScopedStageTimer() {
+        timer_.Mark(stage_);
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    ProfileStage stage_;
+    StageTimer timer_;
+};
+
+#else
+
+class StageTimer {
+public:
+    void Mark(ProfileStage) {
+    }
+};
+
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(ProfileStage) {
+    }
+};
+
+#endif
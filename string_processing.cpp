@@ -1,10 +1,197 @@
 #include "string_processing.h"
-#include <execution>
-#include <numeric>
-#include <iostream>
+
+#include <cstdint>
+#include <cstring>
+
+#if !defined(SEARCH_SERVER_SCALAR_TOKENIZER) \
+    && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SEARCH_SERVER_SIMD_TOKENIZER
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TOKENIZER_ALWAYS_INLINE __forceinline
+#define TOKENIZER_TARGET_AVX2
+#else
+#define TOKENIZER_ALWAYS_INLINE __attribute__((always_inline)) inline
+#define TOKENIZER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
 
 using namespace std;
 
+namespace {
+
+// Признак отсутствия управляющих символов в тексте.
+constexpr size_t NO_CONTROL = string_view::npos;
+
+#ifndef SEARCH_SERVER_SIMD_TOKENIZER
+
+bool IsControl(char c) {
+    return static_cast<unsigned char>(c) < ' ';
+}
+
+// Разбор по байту для платформ без SSE2.
+size_t TokenizeScalar(string_view text, vector<string_view>& words, bool validate) {
+    size_t word_begin = 0;
+    bool in_word = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c == ' ') {
+            if (in_word) {
+                words.push_back(text.substr(word_begin, i - word_begin));
+                in_word = false;
+            }
+            continue;
+        }
+        if (validate && IsControl(c)) {
+            return i;
+        }
+        if (!in_word) {
+            word_begin = i;
+            in_word = true;
+        }
+    }
+    if (in_word) {
+        words.push_back(text.substr(word_begin));
+    }
+    return NO_CONTROL;
+}
+
+#else
+
+unsigned CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Маски блока: бит i - i-й байт является пробелом / управляющим символом.
+struct ChunkMasks {
+    uint32_t spaces;
+    uint32_t controls;
+};
+
+struct ChunkTokenizerState {
+    const char* data;
+    vector<string_view>& words;
+    size_t word_begin = 0;
+    uint32_t previous_space = 1;    // перед текстом как будто стоит пробел
+};
+
+// Границы слов ищутся по маске пробелов: начало слова - не пробел после пробела,
+// конец - пробел после не пробела.
+template <size_t CHUNK_SIZE>
+TOKENIZER_ALWAYS_INLINE void AddChunkWords(ChunkMasks masks, size_t offset, ChunkTokenizerState& state) {
+    constexpr uint32_t CHUNK_MASK = CHUNK_SIZE == 32 ? ~0u : (1u << CHUNK_SIZE) - 1;
+    const uint32_t shifted = (masks.spaces << 1) | state.previous_space;
+    const uint32_t starts = ~masks.spaces & shifted & CHUNK_MASK;
+    const uint32_t ends = masks.spaces & ~shifted & CHUNK_MASK;
+    state.previous_space = (masks.spaces >> (CHUNK_SIZE - 1)) & 1;
+    for (uint32_t boundaries = starts | ends; boundaries != 0; boundaries &= boundaries - 1) {
+        const unsigned bit = CountTrailingZeros(boundaries);
+        if ((starts >> bit) & 1) {
+            state.word_begin = offset + bit;
+        }
+        else {
+            state.words.emplace_back(state.data + state.word_begin, offset + bit - state.word_begin);
+        }
+    }
+}
+
+// Текст сканируется блоками по CHUNK_SIZE байт, хвост дополняется пробелами до целого блока.
+// Функция встраивается в вызывающую, чтобы сканер блока компилировался с её набором инструкций.
+template <size_t CHUNK_SIZE, typename ScanChunk>
+TOKENIZER_ALWAYS_INLINE size_t TokenizeByChunks(string_view text, vector<string_view>& words, bool validate, ScanChunk scan_chunk) {
+    ChunkTokenizerState state{ text.data(), words };
+    const size_t size = text.size();
+
+    size_t offset = 0;
+    for (; offset + CHUNK_SIZE <= size; offset += CHUNK_SIZE) {
+        const ChunkMasks masks = scan_chunk(text.data() + offset);
+        if (validate && masks.controls != 0) {
+            return offset + CountTrailingZeros(masks.controls);
+        }
+        AddChunkWords<CHUNK_SIZE>(masks, offset, state);
+    }
+    if (offset < size) {
+        char tail[CHUNK_SIZE];
+        memset(tail, ' ', CHUNK_SIZE);
+        memcpy(tail, text.data() + offset, size - offset);
+        const ChunkMasks masks = scan_chunk(tail);
+        if (validate && masks.controls != 0) {
+            return offset + CountTrailingZeros(masks.controls);
+        }
+        AddChunkWords<CHUNK_SIZE>(masks, offset, state);
+    }
+    // Дополнение пробелами закрывает последнее слово, иначе текст кончается словом.
+    if (state.previous_space == 0) {
+        words.emplace_back(text.data() + state.word_begin, size - state.word_begin);
+    }
+    return NO_CONTROL;
+}
+
+size_t TokenizeSse2(string_view text, vector<string_view>& words, bool validate) {
+    return TokenizeByChunks<16>(text, words, validate, [](const char* chunk) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk));
+        const __m128i spaces = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+        // Управляющий символ - байт не больше 31 без знака, то есть min(b, 31) == b.
+        const __m128i controls = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(' ' - 1)), bytes);
+        return ChunkMasks{ static_cast<uint32_t>(_mm_movemask_epi8(spaces)), static_cast<uint32_t>(_mm_movemask_epi8(controls)) };
+        });
+}
+
+struct Avx2ChunkScanner {
+    TOKENIZER_TARGET_AVX2 ChunkMasks operator()(const char* chunk) const {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chunk));
+        const __m256i spaces = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+        const __m256i controls = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, _mm256_set1_epi8(' ' - 1)), bytes);
+        return { static_cast<uint32_t>(_mm256_movemask_epi8(spaces)), static_cast<uint32_t>(_mm256_movemask_epi8(controls)) };
+    }
+};
+
+TOKENIZER_TARGET_AVX2 size_t TokenizeAvx2(string_view text, vector<string_view>& words, bool validate) {
+    return TokenizeByChunks<32>(text, words, validate, Avx2ChunkScanner{});
+}
+
+bool IsAvx2Supported() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    const bool os_saves_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0
+        && (_xgetbv(0) & 6) == 6;
+    if (!os_saves_avx) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+using Tokenizer = size_t (*)(string_view, vector<string_view>&, bool);
+
+// Вариант выбирается один раз по возможностям процессора.
+Tokenizer GetTokenizer() {
+#ifdef SEARCH_SERVER_SIMD_TOKENIZER
+    static const Tokenizer tokenizer = IsAvx2Supported() ? TokenizeAvx2 : TokenizeSse2;
+    return tokenizer;
+#else
+    return TokenizeScalar;
+#endif
+}
+
+} // namespace
+
 std::vector<std::string> SplitIntoWords(std::string_view text) {
     std::vector<std::string> words;
     std::string word;
@@ -29,23 +216,19 @@ std::vector<std::string> SplitIntoWords(std::string_view text) {
 
 vector<string_view> SplitIntoWordsView(string_view str) {
     vector<string_view> result;
-    const int64_t pos_end = str.npos;
-    while (true) {
-        int64_t space = str.find(' ', 0);
-      // result.push_back(space == pos_end ? str.substr(0) : str.substr(0, space));
-        if(space == pos_end){
-            result.push_back(str.substr(0));
-            break;
-        }else{
-            string_view tmp = str.substr(0, space);
-            if(!tmp.empty()){
-                result.push_back(tmp);
-            }
-            str.remove_prefix(space+1);
-        }
+    GetTokenizer()(str, result, false);
+    return result;
+}
 
+bool SplitIntoValidWordsView(string_view text, vector<string_view>& words, string_view& invalid_word) {
+    const size_t control = GetTokenizer()(text, words, true);
+    if (control == NO_CONTROL) {
+        return true;
     }
 
-    return result;
+    size_t word_begin = text.rfind(' ', control);
+    word_begin = word_begin == string_view::npos ? 0 : word_begin + 1;
+    const size_t word_end = text.find(' ', control);
+    invalid_word = text.substr(word_begin, word_end == string_view::npos ? string_view::npos : word_end - word_begin);
+    return false;
 }
-
@@ -11,21 +11,24 @@
 	* Парсинг поисковых запросов.
 	**/
 std::vector<std::string> SplitIntoWords(std::string_view text);
+
+// Разбивает текст по пробелам на непустые слова - представления внутри text.
+// На x86 блоки текста сканируются SSE2 или AVX2 (выбирается при первом вызове
+// по возможностям процессора); SEARCH_SERVER_SCALAR_TOKENIZER отключает SIMD.
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str);
 
+// То же, но в том же проходе ищет управляющие символы (коды 0-31). Если они есть,
+// возвращает false, а в invalid_word - слово с первым из них.
+bool SplitIntoValidWordsView(std::string_view text, std::vector<std::string_view>& words, std::string_view& invalid_word);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
-    std::for_each(
-        std::execution::par,
-        strings.begin(),
-        strings.end(),
-        [&non_empty_strings](std::string_view str) {
-            if (!str.empty()) {
-                non_empty_strings.insert(str.data());
-            }
+    for (std::string_view str : strings) {
+        if (!str.empty()) {
+            non_empty_strings.emplace(str);
         }
-    );
+    }
 
     return non_empty_strings;
 }
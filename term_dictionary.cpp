@@ -0,0 +1,101 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+uint32_t TermDictionary::Intern(std::string_view term, TextArena& arena) {
+    if (mapped_) {
+        throw std::logic_error("Mapped term dictionary is read-only"s);
+    }
+
+    // Заполненность таблицы не выше половины, чтобы цепочки пробирования оставались короткими.
+    if ((terms_.size() + 1) * 2 > slots_.size()) {
+        Rehash(std::max(MIN_SLOT_COUNT, slots_.size() * 2));
+    }
+
+    const size_t slot = FindSlot(slots_.data(), slots_.size(), term);
+    if (slots_[slot] != 0) {
+        return slots_[slot] - 1;
+    }
+
+    const uint32_t term_id = static_cast<uint32_t>(terms_.size());
+    terms_.push_back(arena.Get(arena.Append(term)));
+    slots_[slot] = term_id + 1;
+    return term_id;
+}
+
+uint32_t TermDictionary::Find(std::string_view term) const {
+    const uint32_t* slots = mapped_ ? mapped_slots_ : slots_.data();
+    const size_t slot_count = mapped_ ? mapped_slot_count_ : slots_.size();
+    if (slot_count == 0) {
+        return NO_TERM;
+    }
+    const size_t slot = FindSlot(slots, slot_count, term);
+    return slots[slot] == 0 ? NO_TERM : slots[slot] - 1;
+}
+
+std::string_view TermDictionary::GetTerm(uint32_t term_id) const {
+    if (mapped_) {
+        const uint64_t offset = mapped_term_offsets_[term_id];
+        return { mapped_term_bytes_ + offset, static_cast<size_t>(mapped_term_offsets_[term_id + 1] - offset) };
+    }
+    return terms_[term_id];
+}
+
+size_t TermDictionary::size() const {
+    return mapped_ ? mapped_term_count_ : terms_.size();
+}
+
+std::vector<uint32_t> TermDictionary::GetSlots() const {
+    if (mapped_) {
+        return { mapped_slots_, mapped_slots_ + mapped_slot_count_ };
+    }
+    return slots_;
+}
+
+void TermDictionary::AttachMapped(const uint32_t* slots, size_t slot_count, const uint64_t* term_offsets, const char* term_bytes, size_t term_count) {
+    // Пустой словарь может не иметь ни одной ячейки.
+    if ((slot_count & (slot_count - 1)) != 0 || (term_count > 0 && term_count >= slot_count)) {
+        throw std::invalid_argument("Invalid term table"s);
+    }
+    terms_.clear();
+    slots_.clear();
+    mapped_ = true;
+    mapped_slots_ = slots;
+    mapped_slot_count_ = slot_count;
+    mapped_term_offsets_ = term_offsets;
+    mapped_term_bytes_ = term_bytes;
+    mapped_term_count_ = term_count;
+}
+
+uint64_t TermDictionary::Hash(std::string_view term) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : term) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t TermDictionary::FindSlot(const uint32_t* slots, size_t slot_count, std::string_view term) const {
+    const size_t mask = slot_count - 1;
+    size_t slot = static_cast<size_t>(Hash(term)) & mask;
+    while (slots[slot] != 0 && GetTerm(slots[slot] - 1) != term) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void TermDictionary::Rehash(size_t slot_count) {
+    slots_.assign(slot_count, 0);
+    const size_t mask = slot_count - 1;
+    for (uint32_t term_id = 0; term_id < terms_.size(); ++term_id) {
+        size_t slot = static_cast<size_t>(Hash(terms_[term_id])) & mask;
+        while (slots_[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = term_id + 1;
+    }
+}
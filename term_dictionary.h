@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "text_arena.h"
+
+/**
+	* Словарь термов: каждому уникальному слову индекса присваивается
+	* плотный целочисленный идентификатор. Байты терма один раз копируются в арену,
+	* поэтому возвращаемые string_view не зависят от времени жизни документов.
+	*
+	* Поиск идёт по таблице открытой адресации с линейным пробированием и
+	* стабильной хеш-функцией, поэтому таблица сохраняется в снимок индекса
+	* как есть и после загрузки используется на месте (см. AttachMapped).
+	**/
+class TermDictionary {
+public:
+    static constexpr uint32_t NO_TERM = std::numeric_limits<uint32_t>::max();
+
+    // Возвращает идентификатор терма, при первой встрече копируя его в арену.
+    // Арена должна жить не меньше словаря.
+    uint32_t Intern(std::string_view term, TextArena& arena);
+
+    // Возвращает NO_TERM, если терм ещё не встречался.
+    uint32_t Find(std::string_view term) const;
+
+    std::string_view GetTerm(uint32_t term_id) const;
+
+    size_t size() const;
+
+    // Копия ячеек таблицы: идентификатор терма + 1, ноль - пустая ячейка.
+    // Число ячеек - степень двойки.
+    std::vector<uint32_t> GetSlots() const;
+
+    // Переключает словарь на таблицу и термы из снимка: term_offsets содержит
+    // term_count + 1 смещений термов в term_bytes. Данные не копируются и
+    // должны жить не меньше словаря; Intern после этого запрещён.
+    void AttachMapped(const uint32_t* slots, size_t slot_count, const uint64_t* term_offsets, const char* term_bytes, size_t term_count);
+
+    // FNV-1a: значение не зависит от платформы и стандартной библиотеки.
+    static uint64_t Hash(std::string_view term);
+
+private:
+    static constexpr size_t MIN_SLOT_COUNT = 1 << 10;
+
+    std::vector<std::string_view> terms_;
+    std::vector<uint32_t> slots_;
+
+    // Словарь из снимка.
+    bool mapped_ = false;
+    const uint32_t* mapped_slots_ = nullptr;
+    size_t mapped_slot_count_ = 0;
+    const uint64_t* mapped_term_offsets_ = nullptr;
+    const char* mapped_term_bytes_ = nullptr;
+    size_t mapped_term_count_ = 0;
+
+    // Ячейка с термом или первая пустая ячейка на пути пробирования.
+    size_t FindSlot(const uint32_t* slots, size_t slot_count, std::string_view term) const;
+
+    void Rehash(size_t slot_count);
+};
@@ -43,9 +43,13 @@ void FindTopDocuments(const SearchServer& search_server, const std::string& raw_
 void MatchDocuments(const SearchServer& search_server, const std::string& query) {
     try {
         std::cout << "Матчинг документов по запросу: "s << query << std::endl;
-        for(auto document_id : search_server){
-            const auto [words, status] = search_server.MatchDocument(query, document_id);
-            PrintMatchDocumentResult(document_id, words, status);
+        // Запрос разбирается один раз для всех документов.
+        const auto prepared_query = search_server.PrepareQuery(query);
+        const std::vector<int> document_ids(search_server.begin(), search_server.end());
+        const auto results = search_server.MatchDocuments(std::execution::par, prepared_query, document_ids);
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            const auto& [words, status] = results[i];
+            PrintMatchDocumentResult(document_ids[i], words, status);
         }
     } catch (const std::invalid_argument& e) {
         std::cout << "Ошибка матчинга документов на запрос "s << query << ": "s << e.what() << std::endl;
@@ -0,0 +1,129 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+struct Corpus {
+    vector<string> texts;
+    vector<SearchServer::DocumentInput> documents;
+};
+
+Corpus GenerateCorpus(mt19937& generator, int first_id, int document_count) {
+    Corpus corpus;
+    for (int i = 0; i < document_count; ++i) {
+        corpus.texts.push_back(GenerateText(generator, 12, 3000));
+    }
+    for (int i = 0; i < document_count; ++i) {
+        const int id = first_id + i;
+        corpus.documents.push_back({ id, corpus.texts[i], static_cast<DocumentStatus>(id % 3), { id } });
+    }
+    return corpus;
+}
+
+void AssertSameServers(const SearchServer& search_server, const SearchServer& expected_server, const ReferenceSearchServer& reference) {
+    ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount());
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == vector<int>(expected_server.begin(), expected_server.end()));
+    for (const int id : reference.GetDocumentIds()) {
+        const auto word_freqs = search_server.GetWordFrequencies(id);
+        const auto expected_word_freqs = expected_server.GetWordFrequencies(id);
+        ASSERT(word_freqs == expected_word_freqs);
+    }
+
+    mt19937 generator(100);
+    for (int i = 0; i < 50; ++i) {
+        const string query = GenerateText(generator, 4, 3000) + " -w"s + to_string(i + 1);
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT }) {
+            const auto expected = expected_server.FindTopDocuments(query, status, 20);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, status, 20), expected, 0.0);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status, 20), expected, 0.0);
+            AssertSameDocuments(expected, reference.FindTopDocuments(query, status, 20));
+        }
+    }
+}
+
+// Пакет, добавленный после отдельных документов, даёт тот же индекс, что
+// добавление тех же документов по одному.
+void TestBatchMatchesOneByOne() {
+    mt19937 generator(10);
+    const Corpus first = GenerateCorpus(generator, 0, 1000);
+    const Corpus second = GenerateCorpus(generator, 1000, 20'000);
+
+    SearchServer expected_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (const Corpus* corpus : { &first, &second }) {
+        for (const auto& document : corpus->documents) {
+            expected_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            reference.AddDocument(document.id, string(document.text), document.status, document.id);
+        }
+    }
+
+    SearchServer seq_server(STOP_WORDS);
+    SearchServer par_server(STOP_WORDS);
+    for (const auto& document : first.documents) {
+        seq_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        par_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    seq_server.AddDocuments(execution::seq, second.documents);
+    par_server.AddDocuments(execution::par, second.documents);
+    par_server.AddDocuments({});
+
+    AssertSameServers(seq_server, expected_server, reference);
+    AssertSameServers(par_server, expected_server, reference);
+}
+
+// Некорректный документ в любом месте пакета отклоняет весь пакет.
+void TestInvalidBatchLeavesIndexUntouched() {
+    mt19937 generator(11);
+    const Corpus corpus = GenerateCorpus(generator, 0, 5000);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    search_server.AddDocument(100'000, "w1 w2"s, DocumentStatus::ACTUAL, { 1 });
+    reference.AddDocument(100'000, "w1 w2"s, DocumentStatus::ACTUAL, 1);
+
+    const string invalid_text = "w1 w\x01"s;
+    const auto expect_rejected = [&](size_t position, SearchServer::DocumentInput invalid_document) {
+        auto documents = corpus.documents;
+        documents.insert(documents.begin() + position, invalid_document);
+        for (const bool parallel : { false, true }) {
+            try {
+                if (parallel) {
+                    search_server.AddDocuments(execution::par, documents);
+                }
+                else {
+                    search_server.AddDocuments(execution::seq, documents);
+                }
+                ASSERT(false);
+            }
+            catch (const invalid_argument&) {
+            }
+        }
+    };
+    expect_rejected(4000, { 5000, invalid_text, DocumentStatus::ACTUAL, { 1 } });
+    expect_rejected(0, { -1, "w1"sv, DocumentStatus::ACTUAL, { 1 } });
+    expect_rejected(2500, { 100'000, "w1"sv, DocumentStatus::ACTUAL, { 1 } });
+    expect_rejected(5000, { 17, "w1"sv, DocumentStatus::ACTUAL, { 1 } });
+
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1u);
+    ASSERT(search_server.FindTopDocuments("w3"s).empty());
+    AssertSameDocuments(search_server.FindTopDocuments("w1"s), reference.FindTopDocuments("w1"s, DocumentStatus::ACTUAL, 5));
+
+    search_server.AddDocuments(corpus.documents);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 5001u);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestBatchMatchesOneByOne);
+    RUN_TEST(TestInvalidBatchLeavesIndexUntouched);
+}
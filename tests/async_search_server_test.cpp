@@ -0,0 +1,136 @@
+#include "async_search_server.h"
+#include "test_framework.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Сервер, запросы к которому из многих слов идут миллисекунды: пока поток пула
+// занят ими, следующие запросы ждут в очереди.
+const SearchServer& GetSearchServer() {
+    static const SearchServer search_server = [] {
+        mt19937 generator(23);
+        vector<string> texts(50'000);
+        vector<SearchServer::DocumentInput> documents;
+        for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+            for (int i = 0; i < 40; ++i) {
+                texts[id] += "w"s + to_string(uniform_int_distribution<int>(0, 499)(generator)) + ' ';
+            }
+            documents.push_back({ id, texts[id], DocumentStatus::ACTUAL, { id } });
+        }
+        SearchServer result("and"s);
+        result.AddDocuments(documents);
+        return result;
+    }();
+    return search_server;
+}
+
+string MakeSlowQuery(int index) {
+    string query = "w"s + to_string(index);
+    for (int i = 0; i < 500; ++i) {
+        query += " w"s + to_string(i);
+    }
+    return query;
+}
+
+// Ставит в очередь медленные запросы, чтобы единственный поток пула был занят.
+vector<AsyncSearchServer::QueryFuture> OccupyPool(AsyncSearchServer& async_server, int query_count) {
+    vector<AsyncSearchServer::QueryFuture> futures;
+    for (int i = 0; i < query_count; ++i) {
+        futures.push_back(async_server.FindTopDocuments(MakeSlowQuery(i)));
+    }
+    return futures;
+}
+
+void TestCoalescing() {
+    const SearchServer& search_server = GetSearchServer();
+    AsyncSearchServer async_server(search_server, 100, 1);
+    const auto slow_futures = OccupyPool(async_server, 10);
+
+    // Одинаковые запросы объединяются, а запрос с другим статусом - нет.
+    const auto first = async_server.FindTopDocuments("w1 w2 -w3"s);
+    const auto second = async_server.FindTopDocuments("w1 w2 -w3"s);
+    const auto banned = async_server.FindTopDocuments("w1 w2 -w3"s, DocumentStatus::BANNED);
+    ASSERT(&first.get() == &second.get());
+    ASSERT(&first.get() != &banned.get());
+    ASSERT(banned.get().empty());
+
+    const auto expected = search_server.FindTopDocuments("w1 w2 -w3"s);
+    ASSERT_EQUAL(first.get().size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQUAL(first.get()[i].id, expected[i].id);
+    }
+
+    for (const auto& future : slow_futures) {
+        future.wait();
+    }
+
+    // Выполненный запрос не кэшируется: повтор считается заново.
+    const auto repeated = async_server.FindTopDocuments("w1 w2 -w3"s);
+    ASSERT(&repeated.get() != &first.get());
+}
+
+void TestDeadlines() {
+    const SearchServer& search_server = GetSearchServer();
+    AsyncSearchServer async_server(search_server, 100, 1);
+    const auto expired_deadline = chrono::steady_clock::now() - 1s;
+
+    const auto expired = async_server.FindTopDocuments("w4 w5"s, DocumentStatus::ACTUAL, expired_deadline);
+    try {
+        expired.get();
+        ASSERT(false);
+    }
+    catch (const DeadlineExceeded&) {
+    }
+
+    const auto slow_futures = OccupyPool(async_server, 10);
+    // Запрос без срока не присоединяется к поиску с истекающим сроком,
+    // а запрос с ранним сроком присоединяется к поиску без срока.
+    const auto short_search = async_server.FindTopDocuments("w6 w7"s, DocumentStatus::ACTUAL, expired_deadline);
+    const auto long_search = async_server.FindTopDocuments("w6 w7"s);
+    const auto joined = async_server.FindTopDocuments("w6 w7"s, DocumentStatus::ACTUAL, expired_deadline);
+    ASSERT(&joined.get() == &long_search.get());
+    ASSERT(!long_search.get().empty());
+    try {
+        short_search.get();
+        ASSERT(false);
+    }
+    catch (const DeadlineExceeded&) {
+    }
+
+    for (const auto& future : slow_futures) {
+        future.wait();
+    }
+}
+
+void TestAdmissionControl() {
+    const SearchServer& search_server = GetSearchServer();
+    AsyncSearchServer async_server(search_server, 2, 1);
+    const auto slow_futures = OccupyPool(async_server, 2);
+    ASSERT(!async_server.TryFindTopDocuments("w8"s).has_value());
+    // Объединённый запрос места в очереди не занимает.
+    ASSERT(async_server.TryFindTopDocuments(MakeSlowQuery(1)).has_value());
+
+    // FindTopDocuments дожидается места.
+    const auto waited = async_server.FindTopDocuments("w8"s);
+    ASSERT(!waited.get().empty());
+    // Место освобождается сразу после выдачи результата, но не одновременно с ней.
+    while (async_server.GetPendingQueryCount() > 0) {
+        this_thread::yield();
+    }
+    ASSERT(async_server.TryFindTopDocuments("w9"s).has_value());
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestCoalescing);
+    RUN_TEST(TestDeadlines);
+    RUN_TEST(TestAdmissionControl);
+}
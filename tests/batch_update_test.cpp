@@ -0,0 +1,129 @@
+#include "concurrent_search_server.h"
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <algorithm>
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+const DocumentStatus STATUSES[] = { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED };
+
+vector<int> GetSortedIds(const vector<Document>& documents) {
+    vector<int> ids;
+    for (const Document& document : documents) {
+        ids.push_back(document.id);
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Случайная выборка идентификаторов, среди которых есть и неизвестные.
+vector<int> SampleIds(mt19937& generator, int max_id, int count) {
+    vector<int> ids;
+    for (int i = 0; i < count; ++i) {
+        ids.push_back(uniform_int_distribution<int>(0, max_id + 100)(generator));
+    }
+    return ids;
+}
+
+// Пакетное удаление и смена статуса дают ту же выдачу, что перебор.
+void TestSearchServerBatches() {
+    mt19937 generator(16);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 10'000; ++id) {
+        const string text = GenerateText(generator, 10, 200);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+
+    for (int round = 0; round < 6; ++round) {
+        const vector<int> removed_ids = SampleIds(generator, 10'000, 700);
+        if (round % 2 == 0) {
+            search_server.RemoveDocuments(execution::seq, removed_ids);
+        }
+        else {
+            search_server.RemoveDocuments(execution::par, removed_ids);
+        }
+        for (const int id : removed_ids) {
+            reference.RemoveDocument(id);
+        }
+
+        const DocumentStatus status = STATUSES[round % 3];
+        const vector<int> updated_ids = SampleIds(generator, 10'000, 2000);
+        search_server.UpdateStatus(updated_ids, status);
+        for (const int id : updated_ids) {
+            reference.SetStatus(id, status);
+        }
+
+        ASSERT_EQUAL(search_server.GetDocumentCount(), reference.GetDocumentCount());
+        ASSERT(vector<int>(search_server.begin(), search_server.end()) == reference.GetDocumentIds());
+        for (int i = 0; i < 20; ++i) {
+            const string query = GenerateText(generator, 4, 200);
+            for (const DocumentStatus query_status : STATUSES) {
+                const auto expected = reference.FindTopDocuments(query, query_status, 10);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, query_status, 10), expected);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, query_status, 10), expected);
+            }
+            const int id = reference.GetDocumentIds()[i * 100];
+            AssertSameMatch(search_server.MatchDocument(query, id), reference.MatchDocument(query, id));
+        }
+    }
+}
+
+// В сегментированном сервере статус и удаления запечатанных сегментов хранятся
+// рядом с сегментом и переносятся слиянием. Удалённые документы учитываются в IDF
+// до слияния, поэтому сравниваются только найденные документы.
+void TestConcurrentSearchServerBatches() {
+    mt19937 generator(160);
+    ConcurrentSearchServer search_server(STOP_WORDS, 200);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 4000; ++id) {
+        const string text = GenerateText(generator, 8, 100);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+
+    for (int round = 0; round < 4; ++round) {
+        const vector<int> removed_ids = SampleIds(generator, 4000, 300);
+        search_server.RemoveDocuments(removed_ids);
+        for (const int id : removed_ids) {
+            reference.RemoveDocument(id);
+        }
+        const DocumentStatus status = STATUSES[(round + 1) % 3];
+        const vector<int> updated_ids = SampleIds(generator, 4000, 1000);
+        search_server.UpdateStatus(updated_ids, status);
+        for (const int id : updated_ids) {
+            reference.SetStatus(id, status);
+        }
+        if (round % 2 == 1) {
+            search_server.WaitForMerges();
+        }
+
+        ASSERT_EQUAL(search_server.GetDocumentCount(), reference.GetDocumentCount());
+        for (int i = 0; i < 20; ++i) {
+            const string query = GenerateText(generator, 3, 100);
+            for (const DocumentStatus query_status : STATUSES) {
+                const auto expected = reference.FindTopDocuments(query, query_status, 4000);
+                ASSERT(GetSortedIds(search_server.FindTopDocuments(execution::seq, query, query_status, 4000)) == GetSortedIds(expected));
+                ASSERT(GetSortedIds(search_server.FindTopDocuments(execution::par, query, query_status, 4000)) == GetSortedIds(expected));
+            }
+            const int id = reference.GetDocumentIds()[i * 100];
+            ASSERT(get<1>(search_server.MatchDocument(query, id)) == get<1>(reference.MatchDocument(query, id)));
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestSearchServerBatches);
+    RUN_TEST(TestConcurrentSearchServerBatches);
+}
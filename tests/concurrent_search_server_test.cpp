@@ -0,0 +1,172 @@
+#include "concurrent_search_server.h"
+#include "test_framework.h"
+
+#include <atomic>
+#include <execution>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const int PAIR_COUNT = 2000;
+
+string GetPairText(int pair) {
+    // Оба слова второй половины встречаются не во всех документах, поэтому их IDF
+    // положителен и поиск по ним находит все документы.
+    return "pair"s + to_string(pair) + (pair % 2 == 0 ? " alpha"s : " beta"s);
+}
+
+// Документы добавляются и удаляются парами, одним поколением на пару, поэтому
+// запрос видит либо оба документа пары, либо ни одного.
+void TestReadersDuringWrites() {
+    // Маленькие сегменты: за время теста они много раз запечатываются и сливаются.
+    ConcurrentSearchServer search_server("and"s, 256);
+    atomic<int> added_pair_count{ 0 };
+    atomic<bool> writing{ true };
+
+    const auto read = [&](unsigned seed) {
+        mt19937 generator(seed);
+        uint64_t generation = 0;
+        while (writing.load()) {
+            const uint64_t current_generation = search_server.GetGeneration();
+            ASSERT(current_generation >= generation);
+            generation = current_generation;
+
+            const int pair = uniform_int_distribution<int>(0, max(0, added_pair_count.load() - 1))(generator);
+            const auto documents = search_server.FindTopDocuments(execution::seq, "pair"s + to_string(pair));
+            ASSERT(documents.empty() || documents.size() == 2);
+            for (const Document& document : documents) {
+                ASSERT_EQUAL(document.id / 2, pair);
+            }
+
+            const auto all_documents = search_server.FindTopDocuments(execution::par, "alpha beta"s, DocumentStatus::ACTUAL,
+                2 * PAIR_COUNT);
+            ASSERT_EQUAL(all_documents.size() % 2, 0u);
+            set<int> ids;
+            for (const Document& document : all_documents) {
+                ids.insert(document.id);
+            }
+            ASSERT_EQUAL(ids.size(), all_documents.size());
+
+            try {
+                const auto [words, status] = search_server.MatchDocument("alpha beta"s, pair * 2);
+                ASSERT_EQUAL(words.size(), 1u);
+                ASSERT(status == DocumentStatus::ACTUAL);
+            }
+            catch (const out_of_range&) {
+                // Документ ещё не добавлен или уже удалён.
+            }
+        }
+    };
+
+    vector<thread> readers;
+    for (unsigned i = 0; i < 3; ++i) {
+        readers.emplace_back(read, i);
+    }
+
+    set<int> live_ids;
+    for (int pair = 0; pair < PAIR_COUNT; ++pair) {
+        const string text = GetPairText(pair);
+        search_server.AddDocuments({
+            { pair * 2, text, DocumentStatus::ACTUAL, { pair } },
+            { pair * 2 + 1, text, DocumentStatus::ACTUAL, { -pair } },
+            });
+        live_ids.insert({ pair * 2, pair * 2 + 1 });
+        added_pair_count.store(pair + 1);
+
+        if (pair % 3 == 0 && pair >= 10) {
+            const int removed_pair = pair - 10;
+            search_server.RemoveDocuments({ removed_pair * 2, removed_pair * 2 + 1 });
+            live_ids.erase(removed_pair * 2);
+            live_ids.erase(removed_pair * 2 + 1);
+        }
+    }
+    writing.store(false);
+    for (thread& reader : readers) {
+        reader.join();
+    }
+
+    search_server.WaitForMerges();
+    ASSERT_EQUAL(search_server.GetDocumentCount(), live_ids.size());
+    set<int> found_ids;
+    for (const Document& document : search_server.FindTopDocuments("alpha beta"s, DocumentStatus::ACTUAL, 2 * PAIR_COUNT)) {
+        found_ids.insert(document.id);
+    }
+    ASSERT(found_ids == live_ids);
+}
+
+// Запись изнутри чтения того же сервера ждала бы сама себя и бросает исключение,
+// а запись в другой сервер не ждёт его читателей.
+void TestWriteInsideRead() {
+    ConcurrentSearchServer search_server("and"s);
+    ConcurrentSearchServer other_server("and"s);
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+
+    bool thrown = false;
+    const auto documents = search_server.FindTopDocuments("cat"s, [&](int, DocumentStatus, int) {
+        try {
+            search_server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 1 });
+        } catch (const logic_error&) {
+            thrown = true;
+        }
+        other_server.AddDocument(1, "black dog"s, DocumentStatus::ACTUAL, { 1 });
+        other_server.RemoveDocument(1);
+        return true;
+        });
+    ASSERT(thrown);
+    ASSERT_EQUAL(documents.size(), 1u);
+    ASSERT_EQUAL(other_server.GetDocumentCount(), 0u);
+
+    search_server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2u);
+}
+
+// Писатель ждёт читателей, отпустив write_mutex_: пока запрос к старому поколению
+// не закончился, WaitForMerges и фоновое слияние не блокируются.
+void TestWriterWaitsOutsideLock() {
+    ConcurrentSearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+
+    atomic<bool> reading{ false };
+    atomic<bool> release{ false };
+    thread reader([&] {
+        search_server.FindTopDocuments("cat"s, [&](int, DocumentStatus, int) {
+            reading.store(true);
+            while (!release.load()) {
+                this_thread::yield();
+            }
+            return true;
+            });
+        });
+    while (!reading.load()) {
+        this_thread::yield();
+    }
+
+    const uint64_t generation = search_server.GetGeneration();
+    thread writer([&] {
+        search_server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 1 });
+        });
+    while (search_server.GetGeneration() == generation) {
+        this_thread::yield();
+    }
+    search_server.WaitForMerges();
+
+    release.store(true);
+    reader.join();
+    writer.join();
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2u);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestReadersDuringWrites);
+    RUN_TEST(TestWriteInsideRead);
+    RUN_TEST(TestWriterWaitsOutsideLock);
+}
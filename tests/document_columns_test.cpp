@@ -0,0 +1,109 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+// Идентификаторы добавляются вразнобой, рейтинг - среднее оценок.
+void AddDocuments(SearchServer& search_server, ReferenceSearchServer& reference, unsigned seed) {
+    mt19937 generator(seed);
+    vector<int> ids(2000);
+    for (int i = 0; i < static_cast<int>(ids.size()); ++i) {
+        ids[i] = i * 5 + 3;
+    }
+    shuffle(ids.begin(), ids.end(), generator);
+    for (const int id : ids) {
+        const string text = GenerateText(generator, 10, 200);
+        const DocumentStatus status = static_cast<DocumentStatus>(id % 3);
+        search_server.AddDocument(id, text, status, { 3 * id, -id, id });
+        reference.AddDocument(id, text, status, id);
+    }
+}
+
+// Выдача с предикатом по идентификатору, статусу и рейтингу, частоты слов и
+// статус документа берутся из колонок и совпадают с перебором.
+void TestColumnsMatchReference() {
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    AddDocuments(search_server, reference, 2);
+
+    ASSERT_EQUAL(search_server.GetDocumentCount(), reference.GetDocumentCount());
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == reference.GetDocumentIds());
+
+    const auto predicate = [](int document_id, DocumentStatus status, int rating) {
+        return document_id % 2 == 1 && status != DocumentStatus::BANNED && rating < 7000;
+    };
+    mt19937 generator(20);
+    for (int i = 0; i < 100; ++i) {
+        const string query = GenerateText(generator, 4, 200);
+        const auto expected = reference.FindTopDocuments(query, predicate, 5);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, predicate), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, predicate), expected);
+    }
+
+    for (const int id : reference.GetDocumentIds()) {
+        const auto word_freqs = search_server.GetWordFrequencies(id);
+        const auto& expected_word_freqs = reference.GetWordFrequencies(id);
+        ASSERT_EQUAL(word_freqs.size(), expected_word_freqs.size());
+        for (const auto& [word, term_freq] : word_freqs) {
+            ASSERT_NEAR(term_freq, expected_word_freqs.at(string(word)), 1e-12);
+        }
+        ASSERT(get<1>(search_server.MatchDocument("w1"s, id)) == static_cast<DocumentStatus>(id % 3));
+    }
+}
+
+// Документ без оценок имеет рейтинг 0.
+void TestEmptyRatings() {
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "w1 w2"s, DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(2, "w1 w3"s, DocumentStatus::ACTUAL, { -4, -5 });
+    const auto documents = search_server.FindTopDocuments("w1"s);
+    ASSERT_EQUAL(documents.size(), 2u);
+    ASSERT_EQUAL(documents[0].id, 1);
+    ASSERT_EQUAL(documents[0].rating, 0);
+    ASSERT_EQUAL(documents[1].rating, -4);
+}
+
+// Отклонённый документ не оставляет следов: его идентификатор можно добавить снова,
+// а выдача и число документов не меняются.
+void TestRejectedDocumentLeavesNoTrace() {
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "w1 w2"s, DocumentStatus::ACTUAL, { 1 });
+
+    const auto expect_invalid = [&](int document_id, const string& text) {
+        try {
+            search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, { 2 });
+            ASSERT(false);
+        }
+        catch (const invalid_argument&) {
+        }
+    };
+    expect_invalid(-1, "w1"s);
+    expect_invalid(1, "w1"s);
+    expect_invalid(2, "w1 w\x12"s);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1u);
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == vector<int>{ 1 });
+    ASSERT_EQUAL(search_server.FindTopDocuments("w1"s).size(), 1u);
+
+    search_server.AddDocument(2, "w1 w3"s, DocumentStatus::ACTUAL, { 2 });
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2u);
+    ASSERT_EQUAL(search_server.GetWordFrequencies(2).size(), 2u);
+    ASSERT_EQUAL(search_server.FindTopDocuments("w1"s).size(), 2u);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestColumnsMatchReference);
+    RUN_TEST(TestEmptyRatings);
+    RUN_TEST(TestRejectedDocumentLeavesNoTrace);
+}
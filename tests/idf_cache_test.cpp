@@ -0,0 +1,94 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+vector<string> GenerateQueries(mt19937& generator, int query_count) {
+    vector<string> queries;
+    for (int i = 0; i < query_count; ++i) {
+        string query = GenerateText(generator, 4, 150);
+        if (i % 4 == 0) {
+            query += " -w"s + to_string(uniform_int_distribution<int>(1, 149)(generator));
+        }
+        queries.push_back(move(query));
+    }
+    return queries;
+}
+
+void CheckQueries(const SearchServer& search_server, const ReferenceSearchServer& reference, const vector<string>& queries) {
+    for (const string& query : queries) {
+        const auto expected = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, 20);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, 20), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, 20), expected);
+    }
+}
+
+// IDF, посчитанный до добавления или удаления документов, не используется после:
+// выдача после каждого изменения совпадает с перебором.
+void TestIdfFollowsIndexChanges() {
+    mt19937 generator(7);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    const vector<string> queries = GenerateQueries(generator, 20);
+
+    int next_id = 0;
+    for (int round = 0; round < 30; ++round) {
+        for (int i = 0; i < 50; ++i, ++next_id) {
+            const string text = GenerateText(generator, 10, 150);
+            search_server.AddDocument(next_id, text, DocumentStatus::ACTUAL, { next_id });
+            reference.AddDocument(next_id, text, DocumentStatus::ACTUAL, next_id);
+        }
+        CheckQueries(search_server, reference, queries);
+
+        // Удаляется каждый пятый документ этого раунда.
+        for (int id = next_id - 50 + round % 5; id < next_id; id += 5) {
+            search_server.RemoveDocument(id);
+            reference.RemoveDocument(id);
+        }
+        CheckQueries(search_server, reference, queries);
+    }
+}
+
+// Потоки, одновременно пересчитывающие IDF одних и тех же термов, получают
+// одинаковую и верную выдачу.
+void TestConcurrentIdfRecomputation() {
+    mt19937 generator(8);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    const vector<string> queries = GenerateQueries(generator, 50);
+
+    for (int round = 0; round < 5; ++round) {
+        for (int id = round * 1000; id < (round + 1) * 1000; ++id) {
+            const string text = GenerateText(generator, 10, 150);
+            search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+            reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+        }
+
+        vector<thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&] {
+                CheckQueries(search_server, reference, queries);
+            });
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestIdfFollowsIndexChanges);
+    RUN_TEST(TestConcurrentIdfRecomputation);
+}
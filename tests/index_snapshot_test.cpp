@@ -0,0 +1,128 @@
+#include "index_snapshot.h"
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <cstdio>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+string GetTempPath(const string& name) {
+    return (filesystem::temp_directory_path() / name).string();
+}
+
+string ReadFile(const string& path) {
+    ifstream input(path, ios::binary);
+    return string(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+}
+
+SearchServer MakeSearchServer(ReferenceSearchServer& reference) {
+    mt19937 generator(9);
+    SearchServer search_server(STOP_WORDS);
+    for (int id = 0; id < 3000; ++id) {
+        const string text = GenerateText(generator, 12, 200);
+        const DocumentStatus status = id % 7 == 0 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+        search_server.AddDocument(id * 2, text, status, { id });
+        reference.AddDocument(id * 2, text, status, id);
+    }
+    for (int id = 0; id < 6000; id += 22) {
+        search_server.RemoveDocument(id);
+        reference.RemoveDocument(id);
+    }
+    return search_server;
+}
+
+// Снимок отвечает как перебор по тем же документам, без удалённых.
+void TestPlainSnapshotMatchesReference() {
+    ReferenceSearchServer reference(STOP_WORDS);
+    const SearchServer search_server = MakeSearchServer(reference);
+    const string path = GetTempPath("search_server_index_snapshot_test.bin");
+    search_server.SaveSnapshot(path);
+    {
+        const SearchServer snapshot = SearchServer::OpenSnapshot(path);
+        ASSERT_EQUAL(snapshot.GetDocumentCount(), reference.GetDocumentCount());
+        ASSERT(vector<int>(snapshot.begin(), snapshot.end()) == reference.GetDocumentIds());
+
+        mt19937 generator(90);
+        for (int i = 0; i < 100; ++i) {
+            const string query = GenerateText(generator, 4, 200) + " -w"s + to_string(i % 200);
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT }) {
+                const auto expected = reference.FindTopDocuments(query, status, 20);
+                AssertSameDocuments(snapshot.FindTopDocuments(execution::seq, query, status, 20), expected);
+                AssertSameDocuments(snapshot.FindTopDocuments(execution::par, query, status, 20), expected);
+            }
+            const int id = reference.GetDocumentIds()[i * 13];
+            AssertSameMatch(snapshot.MatchDocument(query, id), reference.MatchDocument(query, id));
+        }
+    }
+    remove(path.c_str());
+}
+
+// Байты снимка определяются только содержимым сервера: выравнивание в записях
+// словопозиций и прямого индекса заполнено нулями.
+void TestSnapshotBytesAreDeterministic() {
+    ReferenceSearchServer reference(STOP_WORDS);
+    const SearchServer first_server = MakeSearchServer(reference);
+    const SearchServer second_server = MakeSearchServer(reference);
+    const string first_path = GetTempPath("search_server_index_snapshot_test_1.bin");
+    const string second_path = GetTempPath("search_server_index_snapshot_test_2.bin");
+    first_server.SaveSnapshot(first_path);
+    second_server.SaveSnapshot(second_path);
+    ASSERT(ReadFile(first_path) == ReadFile(second_path));
+
+    {
+        const IndexSnapshot snapshot(first_path);
+        // Запись - номер или терм, нулевое выравнивание и TF: 16 байт.
+        for (const SnapshotSection section : { SnapshotSection::POSTINGS, SnapshotSection::DOCUMENT_TERMS }) {
+            const auto words = snapshot.GetSection<uint32_t>(section);
+            ASSERT(words.size > 0);
+            ASSERT_EQUAL(words.size % 4, 0u);
+            for (size_t i = 1; i < words.size; i += 4) {
+                ASSERT_EQUAL(words.data[i], 0u);
+            }
+        }
+    }
+    remove(first_path.c_str());
+    remove(second_path.c_str());
+}
+
+void TestInvalidSnapshotThrows() {
+    const string path = GetTempPath("search_server_index_snapshot_test_invalid.bin");
+    {
+        ofstream output(path, ios::binary);
+        output << "not a snapshot"s;
+    }
+    try {
+        SearchServer::OpenSnapshot(path);
+        ASSERT(false);
+    }
+    catch (const runtime_error&) {
+    }
+    remove(path.c_str());
+
+    try {
+        SearchServer::OpenSnapshot(GetTempPath("search_server_index_snapshot_test_missing.bin"));
+        ASSERT(false);
+    }
+    catch (const runtime_error&) {
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestPlainSnapshotMatchesReference);
+    RUN_TEST(TestSnapshotBytesAreDeterministic);
+    RUN_TEST(TestInvalidSnapshotThrows);
+}
@@ -0,0 +1,81 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+#include "term_dictionary.h"
+#include "text_arena.h"
+
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0 w1"s;
+
+// Идентификаторы выдаются подряд с нуля, повторный терм получает прежний, а
+// байты терма не зависят от строки, из которой он добавлен.
+void TestTermDictionary() {
+    TextArena arena;
+    TermDictionary dictionary;
+    ASSERT_EQUAL(dictionary.Find("a"s), TermDictionary::NO_TERM);
+
+    const int term_count = 100'000;
+    for (int i = 0; i < term_count; ++i) {
+        const string term = "term"s + to_string(i);
+        ASSERT_EQUAL(dictionary.Intern(term, arena), static_cast<uint32_t>(i));
+    }
+    ASSERT_EQUAL(dictionary.size(), static_cast<size_t>(term_count));
+    for (int i = 0; i < term_count; i += 7) {
+        const string term = "term"s + to_string(i);
+        ASSERT_EQUAL(dictionary.Intern(term, arena), static_cast<uint32_t>(i));
+        ASSERT_EQUAL(dictionary.Find(term), static_cast<uint32_t>(i));
+        ASSERT(dictionary.GetTerm(i) == term);
+    }
+    ASSERT_EQUAL(dictionary.size(), static_cast<size_t>(term_count));
+    ASSERT_EQUAL(dictionary.Find("term"s), TermDictionary::NO_TERM);
+    ASSERT_EQUAL(dictionary.Find("term100000"s), TermDictionary::NO_TERM);
+}
+
+// Поиск по спискам словопозиций совпадает с перебором, в том числе после удалений.
+void TestSearchMatchesReference() {
+    mt19937 generator(1);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 3000; ++id) {
+        const string text = GenerateText(generator, 12, 300);
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(id, text, status, { id });
+        reference.AddDocument(id, text, status, id);
+    }
+
+    const auto check = [&] {
+        mt19937 query_generator(10);
+        for (int i = 0; i < 100; ++i) {
+            string query = GenerateText(query_generator, 4, 300);
+            if (i % 3 == 0) {
+                query += " -w"s + to_string(uniform_int_distribution<int>(2, 299)(query_generator));
+            }
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                const auto expected = reference.FindTopDocuments(query, status, 5);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, status), expected);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status), expected);
+            }
+        }
+    };
+    check();
+
+    for (int id = 0; id < 3000; id += 3) {
+        search_server.RemoveDocument(id);
+        reference.RemoveDocument(id);
+    }
+    check();
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestTermDictionary);
+    RUN_TEST(TestSearchMatchesReference);
+}
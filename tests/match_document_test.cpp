@@ -0,0 +1,111 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0 w1"s;
+const int WORD_COUNT = 20'000;
+
+string GenerateQuery(mt19937& generator, int max_word_count) {
+    // Повторы слов в длинном запросе схлопываются при разборе.
+    string query = GenerateText(generator, max_word_count, WORD_COUNT);
+    const int minus_word_count = uniform_int_distribution<int>(0, 2)(generator);
+    for (int i = 0; i < minus_word_count; ++i) {
+        query += " -w"s + to_string(uniform_int_distribution<int>(0, WORD_COUNT - 1)(generator));
+    }
+    return query;
+}
+
+// Короткие документы сверяются с длинными запросами по таблице запроса, длинные
+// документы с короткими запросами - бинарным поиском; оба способа дают то же, что
+// перебор.
+void TestMatchDocumentMatchesReference() {
+    mt19937 generator(20);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    vector<int> ids;
+    for (int id = 0; id < 300; ++id) {
+        const int max_word_count = id % 50 == 0 ? 30'000 : 20;
+        const string text = GenerateText(generator, max_word_count, WORD_COUNT);
+        const DocumentStatus status = id % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(id * 3, text, status, { id });
+        reference.AddDocument(id * 3, text, status, id);
+        ids.push_back(id * 3);
+    }
+
+    for (int i = 0; i < 60; ++i) {
+        const string query = GenerateQuery(generator, i % 2 == 0 ? 6 : 6000);
+        const auto prepared_query = search_server.PrepareQuery(query);
+        for (size_t j = i % 7; j < ids.size(); j += 7) {
+            const auto expected = reference.MatchDocument(query, ids[j]);
+            AssertSameMatch(search_server.MatchDocument(query, ids[j]), expected);
+            AssertSameMatch(search_server.MatchDocument(execution::seq, query, ids[j]), expected);
+            AssertSameMatch(search_server.MatchDocument(execution::par, query, ids[j]), expected);
+            AssertSameMatch(search_server.MatchDocument(execution::seq, prepared_query, ids[j]), expected);
+            AssertSameMatch(search_server.MatchDocument(execution::par, prepared_query, ids[j]), expected);
+        }
+    }
+}
+
+// Минус-слово, которое есть и среди плюс-слов, исключает документ.
+void TestMinusWordAlsoPlusWord() {
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "w2 w3 w4"s, DocumentStatus::ACTUAL, { 1 });
+    for (const string& query : { "w2 w3 -w3"s, "-w3 w3 w2"s }) {
+        ASSERT(get<0>(search_server.MatchDocument(execution::seq, query, 1)).empty());
+        ASSERT(get<0>(search_server.MatchDocument(execution::par, query, 1)).empty());
+        ASSERT(get<0>(search_server.MatchDocuments(execution::seq, search_server.PrepareQuery(query), { 1 })[0]).empty());
+    }
+}
+
+// MatchDocuments по подготовленному запросу берёт сохранённый план, пока индекс не
+// изменился, а после изменения строит план заново: слово, которого не было в
+// словаре при подготовке, находится в новом документе.
+void TestMatchDocumentsWithPreparedPlan() {
+    mt19937 generator(21);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    vector<int> ids;
+    for (int id = 0; id < 500; ++id) {
+        const string text = GenerateText(generator, 20, 300);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+        ids.push_back(id);
+    }
+
+    const string query = "w2 w3 w5 w7 w11 -w13 fresh"s;
+    const auto prepared_query = search_server.PrepareQuery(query);
+    const auto check = [&] {
+        const auto seq_matches = search_server.MatchDocuments(execution::seq, prepared_query, ids);
+        const auto par_matches = search_server.MatchDocuments(execution::par, prepared_query, ids);
+        ASSERT_EQUAL(seq_matches.size(), ids.size());
+        ASSERT_EQUAL(par_matches.size(), ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const auto expected = reference.MatchDocument(query, ids[i]);
+            AssertSameMatch(seq_matches[i], expected);
+            AssertSameMatch(par_matches[i], expected);
+        }
+    };
+    check();
+
+    search_server.AddDocument(500, "fresh w2"s, DocumentStatus::ACTUAL, { 500 });
+    reference.AddDocument(500, "fresh w2"s, DocumentStatus::ACTUAL, 500);
+    ids.push_back(500);
+    check();
+    AssertSameMatch(search_server.MatchDocument(prepared_query, 500), reference.MatchDocument(query, 500));
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestMatchDocumentMatchesReference);
+    RUN_TEST(TestMinusWordAlsoPlusWord);
+    RUN_TEST(TestMatchDocumentsWithPreparedPlan);
+}
@@ -0,0 +1,98 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <cstdio>
+#include <execution>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+void CheckMatchDocuments(const SearchServer& search_server, const ReferenceSearchServer& reference) {
+    mt19937 generator(190);
+    const vector<int> all_ids = reference.GetDocumentIds();
+    for (int i = 0; i < 40; ++i) {
+        const string query = GenerateText(generator, 6, 300) + (i % 2 == 0 ? " -w"s + to_string(i + 1) : ""s);
+        // Идентификаторы вразнобой и с повторами.
+        vector<int> ids;
+        for (int j = 0; j < 300; ++j) {
+            ids.push_back(all_ids[uniform_int_distribution<size_t>(0, all_ids.size() - 1)(generator)]);
+        }
+        const auto prepared_query = search_server.PrepareQuery(query);
+        const auto seq_matches = search_server.MatchDocuments(execution::seq, query, ids);
+        const auto par_matches = search_server.MatchDocuments(execution::par, query, ids);
+        const auto prepared_matches = search_server.MatchDocuments(execution::par, prepared_query, ids);
+        ASSERT_EQUAL(seq_matches.size(), ids.size());
+        ASSERT_EQUAL(par_matches.size(), ids.size());
+        ASSERT_EQUAL(prepared_matches.size(), ids.size());
+        for (size_t j = 0; j < ids.size(); ++j) {
+            const auto expected = reference.MatchDocument(query, ids[j]);
+            AssertSameMatch(seq_matches[j], expected);
+            AssertSameMatch(par_matches[j], expected);
+            AssertSameMatch(prepared_matches[j], expected);
+        }
+    }
+    ASSERT(search_server.MatchDocuments("w1"s, {}).empty());
+}
+
+SearchServer MakeSearchServer(ReferenceSearchServer& reference) {
+    mt19937 generator(19);
+    SearchServer search_server(STOP_WORDS);
+    for (int id = 0; id < 4000; ++id) {
+        const string text = GenerateText(generator, 30, 300);
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(id, text, status, { id });
+        reference.AddDocument(id, text, status, id);
+    }
+    for (int id = 0; id < 4000; id += 9) {
+        search_server.RemoveDocument(id);
+        reference.RemoveDocument(id);
+    }
+    return search_server;
+}
+
+// Пакетный MatchDocument по прямому индексу совпадает с перебором в памяти и в
+// снимках обоих форматов.
+void TestMatchDocumentsMatchesReference() {
+    ReferenceSearchServer reference(STOP_WORDS);
+    const SearchServer search_server = MakeSearchServer(reference);
+    CheckMatchDocuments(search_server, reference);
+
+    const string path = (filesystem::temp_directory_path() / "search_server_match_documents_test.bin").string();
+    for (const auto format : { SearchServer::PostingFormat::PLAIN, SearchServer::PostingFormat::COMPRESSED }) {
+        search_server.SaveSnapshot(path, format);
+        {
+            const SearchServer snapshot = SearchServer::OpenSnapshot(path);
+            CheckMatchDocuments(snapshot, reference);
+        }
+        remove(path.c_str());
+    }
+}
+
+// Неизвестный или удалённый идентификатор обнаруживается до сопоставления.
+void TestUnknownIdThrows() {
+    ReferenceSearchServer reference(STOP_WORDS);
+    const SearchServer search_server = MakeSearchServer(reference);
+    for (const int id : { 9, 4000, -1 }) {
+        try {
+            search_server.MatchDocuments(execution::par, "w1 w2"s, { 1, 2, id, 3 });
+            ASSERT(false);
+        }
+        catch (const out_of_range&) {
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestMatchDocumentsMatchesReference);
+    RUN_TEST(TestUnknownIdThrows);
+}
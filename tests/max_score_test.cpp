@@ -0,0 +1,77 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0 w7"s;
+const int WORD_COUNT = 200;
+
+// Частота слова убывает с номером, как в текстах: у редких слов оценка вклада
+// низкая, и MaxScore отсекает по ним документы.
+string GenerateWord(mt19937& generator) {
+    const int a = uniform_int_distribution<int>(0, WORD_COUNT - 1)(generator);
+    const int b = uniform_int_distribution<int>(0, WORD_COUNT - 1)(generator);
+    return "w"s + to_string(min(a, b));
+}
+
+string GenerateQuery(mt19937& generator) {
+    string query = GenerateText(generator, 6, GenerateWord);
+    if (uniform_int_distribution<int>(0, 2)(generator) == 0) {
+        query += " -"s + GenerateWord(generator);
+    }
+    // Редкие слова дают термы с маленькой оценкой вклада.
+    query += " w"s + to_string(uniform_int_distribution<int>(WORD_COUNT / 2, WORD_COUNT - 1)(generator));
+    return query;
+}
+
+// Документов больше, чем в одном окне подсчёта, поэтому порог переходит между
+// окнами, а при параллельной политике окна считаются независимо.
+void TestMaxScoreMatchesBruteForce() {
+    mt19937 generator(6);
+    const int document_count = 40'000;
+    const DocumentStatus statuses[] = { DocumentStatus::ACTUAL, DocumentStatus::ACTUAL, DocumentStatus::ACTUAL, DocumentStatus::BANNED };
+
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < document_count; ++id) {
+        const string text = GenerateText(generator, 12, GenerateWord);
+        const DocumentStatus status = statuses[id % 4];
+        // Разные рейтинги однозначно упорядочивают документы с равной релевантностью.
+        search_server.AddDocument(id, text, status, { id });
+        reference.AddDocument(id, text, status, id);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        const string query = GenerateQuery(generator);
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+            const auto all_expected = reference.FindTopDocuments(query, status, 100);
+            for (const size_t result_count : { size_t{ 1 }, SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT, size_t{ 100 } }) {
+                const vector<Document> expected(all_expected.begin(), all_expected.begin() + min(result_count, all_expected.size()));
+                AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, status, result_count), expected);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status, result_count), expected);
+            }
+        }
+    }
+}
+
+// Запрос из одних минус-слов и стоп-слов ничего не находит.
+void TestQueryWithoutPlusWords() {
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "w1 w2 w3"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(search_server.FindTopDocuments(execution::seq, "w0 -w1"s).empty());
+    ASSERT(search_server.FindTopDocuments(execution::par, "w0 -w1"s).empty());
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestMaxScoreMatchesBruteForce);
+    RUN_TEST(TestQueryWithoutPlusWords);
+}
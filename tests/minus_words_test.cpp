@@ -0,0 +1,111 @@
+#include "concurrent_map.h"
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+// Частые слова w1...w9 есть во многих документах, редкие r<k> - в немногих.
+string GenerateDocument(mt19937& generator, int id) {
+    return GenerateText(generator, 8, 10) + " "s + GenerateText(generator, 4, 3000) + " r"s + to_string(id % 500);
+}
+
+// Длинные минус-списки при коротких плюс-списках, и наоборот: оба способа
+// исключения дают ту же выдачу, что перебор.
+void TestMinusWordsMatchReference() {
+    mt19937 generator(5);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 20'000; ++id) {
+        const string text = GenerateDocument(generator, id);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+
+    const auto rare_word = [&] {
+        return "r"s + to_string(uniform_int_distribution<int>(0, 499)(generator));
+    };
+    const auto common_word = [&] {
+        return "w"s + to_string(uniform_int_distribution<int>(1, 9)(generator));
+    };
+    vector<string> queries;
+    for (int i = 0; i < 40; ++i) {
+        queries.push_back(rare_word() + " -"s + common_word());
+        queries.push_back(rare_word() + " "s + rare_word() + " -"s + common_word() + " -"s + common_word());
+        queries.push_back(common_word() + " "s + common_word() + " -"s + rare_word());
+        queries.push_back(common_word() + " -"s + common_word() + " -missing"s);
+        // Минус-слово совпадает с плюс-словом.
+        const string word = rare_word();
+        queries.push_back(word + " -"s + word);
+    }
+    for (const string& query : queries) {
+        for (const size_t result_count : { 5u, 50u }) {
+            const auto expected = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, result_count);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, result_count), expected);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, result_count), expected);
+        }
+    }
+}
+
+// Исключённый минус-словом документ не попадает в выдачу и не передаётся предикату.
+void TestExcludedDocumentsSkipPredicate() {
+    SearchServer search_server(STOP_WORDS);
+    for (int id = 0; id < 100; ++id) {
+        search_server.AddDocument(id, id % 10 == 0 ? "w1 w2"s : "w1 w3"s, DocumentStatus::ACTUAL, { id });
+    }
+    for (const string& query : { "w1 -w2"s, "w1 -w3"s }) {
+        bool excluded_seen = false;
+        const auto predicate = [&](int document_id, DocumentStatus, int) {
+            excluded_seen = excluded_seen || (document_id % 10 == 0) == (query == "w1 -w2"s);
+            return true;
+        };
+        const auto documents = search_server.FindTopDocuments(execution::seq, query, predicate, 100);
+        ASSERT(!excluded_seen);
+        ASSERT_EQUAL(documents.size(), query == "w1 -w2"s ? 90u : 10u);
+    }
+}
+
+// erase блокирует только корзину ключа: потоки, одновременно добавляющие и
+// удаляющие свои ключи, не теряют чужих изменений.
+void TestConcurrentMapErase() {
+    ConcurrentMap<int, int> map(7);
+    vector<thread> threads;
+    for (int thread_index = 0; thread_index < 4; ++thread_index) {
+        threads.emplace_back([&map, thread_index] {
+            for (int key = thread_index; key < 20'000; key += 4) {
+                map[key].ref_to_value = key;
+                if (key % 3 == 0) {
+                    map.erase(key);
+                }
+            }
+            map.erase(-1 - thread_index);
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+
+    const auto result = map.BuildOrdinaryMap();
+    ASSERT_EQUAL(result.size(), 20'000u - 6667u);
+    for (const auto& [key, value] : result) {
+        ASSERT(key % 3 != 0);
+        ASSERT_EQUAL(value, key);
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestMinusWordsMatchReference);
+    RUN_TEST(TestExcludedDocumentsSkipPredicate);
+    RUN_TEST(TestConcurrentMapErase);
+}
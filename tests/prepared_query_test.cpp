@@ -0,0 +1,132 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+vector<string> GenerateQueries(mt19937& generator, int query_count) {
+    vector<string> queries;
+    for (int i = 0; i < query_count; ++i) {
+        string query = GenerateText(generator, 4, 80);
+        if (i % 3 == 0) {
+            query += " -w"s + to_string(uniform_int_distribution<int>(1, 79)(generator));
+        }
+        queries.push_back(move(query));
+    }
+    return queries;
+}
+
+// Запросы, разобранные между удалением документов и очисткой списков
+// словопозиций, выполняются после неё так же, как новые.
+void TestPreparedQueryAfterPurge() {
+    mt19937 generator(1);
+    const int document_count = 20'000;
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < document_count; ++id) {
+        const string text = GenerateText(generator, 10, 80);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+
+    // Меньше порога автоматической очистки: словопозиции остаются до PurgeRemovedDocuments.
+    for (int i = 0; i < 500; ++i) {
+        const int id = i * 37 % document_count;
+        search_server.RemoveDocument(id);
+        reference.RemoveDocument(id);
+    }
+
+    const vector<string> queries = GenerateQueries(generator, 50);
+    vector<SearchServer::PreparedQuery> prepared_queries;
+    for (const string& query : queries) {
+        prepared_queries.push_back(search_server.PrepareQuery(query));
+    }
+    search_server.PurgeRemovedDocuments();
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        for (size_t result_count : { SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT, size_t{ 1000 } }) {
+            const auto expected = reference.FindTopDocuments(queries[i], DocumentStatus::ACTUAL, result_count);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::seq, prepared_queries[i], DocumentStatus::ACTUAL, result_count),
+                expected);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, prepared_queries[i], DocumentStatus::ACTUAL, result_count),
+                expected);
+        }
+        for (int id = 1; id < document_count; id += 997) {
+            ASSERT(search_server.MatchDocument(execution::seq, prepared_queries[i], id) == search_server.MatchDocument(queries[i], id));
+            ASSERT(search_server.MatchDocument(execution::par, prepared_queries[i], id) == search_server.MatchDocument(queries[i], id));
+        }
+    }
+}
+
+// Запрос, разобранный другим сервером, разрешается заново, даже если новый сервер
+// создан по тому же адресу.
+void TestPreparedQueryOfAnotherServer() {
+    mt19937 generator(2);
+    const string query = "w1 w2 w3 -w4"s;
+
+    optional<SearchServer> search_server(in_place, STOP_WORDS);
+    for (int id = 0; id < 1000; ++id) {
+        search_server->AddDocument(id, GenerateText(generator, 10, 80), DocumentStatus::ACTUAL, { id });
+    }
+    const SearchServer::PreparedQuery prepared_query = search_server->PrepareQuery(query);
+
+    search_server.emplace(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 300; ++id) {
+        const string text = GenerateText(generator, 10, 80);
+        search_server->AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+
+    const auto expected = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000);
+    AssertSameDocuments(search_server->FindTopDocuments(execution::seq, prepared_query, DocumentStatus::ACTUAL, 1000), expected);
+    AssertSameDocuments(search_server->FindTopDocuments(execution::par, prepared_query, DocumentStatus::ACTUAL, 1000), expected);
+}
+
+// Запрос, подготовленный до перемещения сервера, выполняется на новом месте и
+// видит документы, добавленные после перемещения.
+void TestPreparedQueryOfMovedServer() {
+    mt19937 generator(3);
+    const string query = "w1 w2 w3 -w4"s;
+
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 1000; ++id) {
+        const string text = GenerateText(generator, 10, 80);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+    const SearchServer::PreparedQuery prepared_query = search_server.PrepareQuery(query);
+
+    SearchServer moved_server = move(search_server);
+    AssertSameDocuments(moved_server.FindTopDocuments(execution::seq, prepared_query, DocumentStatus::ACTUAL, 1000),
+        reference.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000));
+
+    for (int id = 1000; id < 1100; ++id) {
+        const string text = GenerateText(generator, 10, 80);
+        moved_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+    AssertSameDocuments(moved_server.FindTopDocuments(execution::par, prepared_query, DocumentStatus::ACTUAL, 1000),
+        reference.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000));
+    for (int id = 0; id < 1100; id += 50) {
+        AssertSameMatch(moved_server.MatchDocument(prepared_query, id), reference.MatchDocument(query, id));
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestPreparedQueryAfterPurge);
+    RUN_TEST(TestPreparedQueryOfAnotherServer);
+    RUN_TEST(TestPreparedQueryOfMovedServer);
+}
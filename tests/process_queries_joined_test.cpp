@@ -0,0 +1,72 @@
+#include "process_queries.h"
+#include "reference_search_server.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+// Выдачи запросов идут подряд в порядке запросов, в том числе короткие и пустые.
+void TestJoinedResultsMatchReference() {
+    mt19937 generator(22);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 3000; ++id) {
+        // Редкое слово r<k> встречается в трёх документах.
+        const string text = GenerateText(generator, 8, 400) + " r"s + to_string(id % 1000);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+
+    vector<string> queries;
+    for (int i = 0; i < 200; ++i) {
+        // Редкие слова находят меньше DEFAULT_RESULT_DOCUMENT_COUNT документов,
+        // отсутствующие в индексе и стоп-слова - ни одного.
+        switch (i % 4) {
+        case 0:
+            queries.push_back(GenerateText(generator, 3, 400));
+            break;
+        case 1:
+            queries.push_back("r"s + to_string(uniform_int_distribution<int>(0, 999)(generator)) + " -w"s
+                + to_string(uniform_int_distribution<int>(1, 399)(generator)));
+            break;
+        case 2:
+            queries.push_back("missing"s + to_string(i));
+            break;
+        default:
+            queries.push_back("w0"s);
+        }
+    }
+
+    vector<Document> expected;
+    size_t short_result_count = 0;
+    size_t empty_result_count = 0;
+    for (const string& query : queries) {
+        const auto documents = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT);
+        short_result_count += !documents.empty() && documents.size() < SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT;
+        empty_result_count += documents.empty();
+        expected.insert(expected.end(), documents.begin(), documents.end());
+    }
+    ASSERT(short_result_count >= queries.size() / 8);
+    ASSERT(empty_result_count >= queries.size() / 2);
+
+    AssertSameDocuments(ProcessQueriesJoined(search_server, queries), expected);
+}
+
+void TestNoQueries() {
+    SearchServer search_server(STOP_WORDS);
+    search_server.AddDocument(1, "w1 w2"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(ProcessQueriesJoined(search_server, {}).empty());
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestJoinedResultsMatchReference);
+    RUN_TEST(TestNoQueries);
+}
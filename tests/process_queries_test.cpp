@@ -0,0 +1,101 @@
+#include "process_queries.h"
+#include "reference_search_server.h"
+
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Документов и частых слов хватает, чтобы часть запросов считалась по окнам
+// задачами пула, а часть - последовательно.
+const SearchServer& GetSearchServer() {
+    static const SearchServer search_server = [] {
+        mt19937 generator(21);
+        vector<string> texts(60'000);
+        vector<SearchServer::DocumentInput> documents;
+        for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+            for (int i = 0; i < 4; ++i) {
+                texts[id] += "f"s + to_string(uniform_int_distribution<int>(0, 9)(generator)) + ' ';
+                texts[id] += "w"s + to_string(uniform_int_distribution<int>(0, 999)(generator)) + ' ';
+            }
+            documents.push_back({ id, texts[id], DocumentStatus::ACTUAL, { id } });
+        }
+        SearchServer result("and"s);
+        result.AddDocuments(documents);
+        return result;
+    }();
+    return search_server;
+}
+
+vector<string> GenerateQueries(int query_count) {
+    mt19937 generator(12);
+    vector<string> queries;
+    for (int i = 0; i < query_count; ++i) {
+        string query;
+        // Каждый пятый запрос из частых слов - с длинными списками словопозиций.
+        for (int j = 0; j < 4; ++j) {
+            query += i % 5 == 0
+                ? "f"s + to_string(uniform_int_distribution<int>(0, 9)(generator)) + ' '
+                : "w"s + to_string(uniform_int_distribution<int>(0, 999)(generator)) + ' ';
+        }
+        if (i % 3 == 0) {
+            query += "-w"s + to_string(uniform_int_distribution<int>(0, 999)(generator));
+        }
+        queries.push_back(move(query));
+    }
+    return queries;
+}
+
+void TestResultsMatchSequentialSearch() {
+    const SearchServer& search_server = GetSearchServer();
+    const vector<string> queries = GenerateQueries(300);
+
+    const auto results = ProcessQueries(search_server, queries);
+    ASSERT_EQUAL(results.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        AssertSameDocuments(results[i], search_server.FindTopDocuments(queries[i]));
+    }
+}
+
+// Выдача каждого запроса передаётся ровно один раз, callback не вызывается одновременно.
+void TestCallbackCalledOncePerQuery() {
+    const SearchServer& search_server = GetSearchServer();
+    const vector<string> queries = GenerateQueries(300);
+
+    vector<int> call_counts(queries.size());
+    atomic<int> running_callback_count{ 0 };
+    ProcessQueries(search_server, queries, [&](size_t query_index, vector<Document> documents) {
+        ASSERT_EQUAL(running_callback_count.fetch_add(1), 0);
+        ++call_counts[query_index];
+        AssertSameDocuments(documents, search_server.FindTopDocuments(queries[query_index]));
+        running_callback_count.fetch_sub(1);
+        });
+    for (const int call_count : call_counts) {
+        ASSERT_EQUAL(call_count, 1);
+    }
+}
+
+void TestInvalidQueryThrows() {
+    const SearchServer& search_server = GetSearchServer();
+    vector<string> queries = GenerateQueries(100);
+    queries[37] = "w1 --w2"s;
+    try {
+        ProcessQueries(search_server, queries);
+        ASSERT(false);
+    }
+    catch (const invalid_argument&) {
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestResultsMatchSequentialSearch);
+    RUN_TEST(TestCallbackCalledOncePerQuery);
+    RUN_TEST(TestInvalidQueryThrows);
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "string_processing.h"
+#include "test_framework.h"
+
+/**
+	* Поиск полным перебором по формуле TF-IDF - эталон, с которым тесты сравнивают
+	* выдачу SearchServer. Рейтинг документа задаётся одним числом.
+	**/
+class ReferenceSearchServer {
+public:
+    explicit ReferenceSearchServer(const std::string& stop_words) {
+        for (std::string_view word : SplitIntoWords(stop_words)) {
+            stop_words_.emplace(word);
+        }
+    }
+
+    void AddDocument(int document_id, const std::string& text, DocumentStatus status, int rating) {
+        ReferenceDocument& document = documents_[document_id];
+        document = ReferenceDocument{ {}, status, rating };
+        std::vector<std::string> words;
+        for (std::string_view word : SplitIntoWords(text)) {
+            if (!stop_words_.count(std::string(word))) {
+                words.emplace_back(word);
+            }
+        }
+        for (const std::string& word : words) {
+            document.word_freqs[word] += 1.0 / words.size();
+        }
+    }
+
+    void RemoveDocument(int document_id) {
+        documents_.erase(document_id);
+    }
+
+    void SetStatus(int document_id, DocumentStatus status) {
+        const auto it = documents_.find(document_id);
+        if (it != documents_.end()) {
+            it->second.status = status;
+        }
+    }
+
+    size_t GetDocumentCount() const {
+        return documents_.size();
+    }
+
+    // Идентификаторы документов по возрастанию.
+    std::vector<int> GetDocumentIds() const {
+        std::vector<int> ids;
+        for (const auto& [document_id, document] : documents_) {
+            ids.push_back(document_id);
+        }
+        return ids;
+    }
+
+    const std::map<std::string, double>& GetWordFrequencies(int document_id) const {
+        return documents_.at(document_id).word_freqs;
+    }
+
+    // document_predicate(id, status, rating), как у SearchServer.
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate, size_t result_count) const {
+        const auto [plus_words, minus_words] = ParseQuery(raw_query);
+
+        std::map<std::string, double> idfs;
+        for (const std::string& word : plus_words) {
+            idfs[word] = ComputeIdf(word);
+        }
+
+        std::vector<Document> result;
+        for (const auto& [document_id, document] : documents_) {
+            if (!document_predicate(document_id, document.status, document.rating)) {
+                continue;
+            }
+            const auto has_word = [&](const std::string& word) {
+                return document.word_freqs.count(word) > 0;
+            };
+            if (std::any_of(minus_words.begin(), minus_words.end(), has_word)) {
+                continue;
+            }
+            double relevance = 0;
+            bool found = false;
+            for (const std::string& word : plus_words) {
+                const auto it = document.word_freqs.find(word);
+                if (it != document.word_freqs.end()) {
+                    relevance += it->second * idfs.at(word);
+                    found = true;
+                }
+            }
+            if (found) {
+                result.push_back({ document_id, relevance, document.rating });
+            }
+        }
+        std::sort(result.begin(), result.end(), IsMoreRelevant);
+        result.resize(std::min(result.size(), result_count));
+        return result;
+    }
+
+    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status, size_t result_count) const {
+        return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+            }, result_count);
+    }
+
+    // Плюс-слова запроса из документа по алфавиту; пусто, если в документе есть минус-слово.
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const {
+        const ReferenceDocument& document = documents_.at(document_id);
+        const auto [plus_words, minus_words] = ParseQuery(raw_query);
+        std::vector<std::string> words;
+        for (const std::string& word : minus_words) {
+            if (document.word_freqs.count(word)) {
+                return { words, document.status };
+            }
+        }
+        for (const std::string& word : plus_words) {
+            if (document.word_freqs.count(word)) {
+                words.push_back(word);
+            }
+        }
+        return { words, document.status };
+    }
+
+private:
+    struct ReferenceDocument {
+        std::map<std::string, double> word_freqs;
+        DocumentStatus status;
+        int rating;
+    };
+
+    std::set<std::string> stop_words_;
+    std::map<int, ReferenceDocument> documents_;
+
+    // Тот же порядок, что у выдачи SearchServer: по убыванию релевантности, при
+    // равной с точностью 1e-6 - по убыванию рейтинга.
+    static bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+        if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.relevance > rhs.relevance;
+    }
+
+    std::pair<std::set<std::string>, std::set<std::string>> ParseQuery(const std::string& raw_query) const {
+        std::set<std::string> plus_words;
+        std::set<std::string> minus_words;
+        for (std::string_view word : SplitIntoWords(raw_query)) {
+            const bool is_minus = word[0] == '-';
+            if (is_minus) {
+                word.remove_prefix(1);
+            }
+            if (stop_words_.count(std::string(word))) {
+                continue;
+            }
+            (is_minus ? minus_words : plus_words).emplace(word);
+        }
+        return { plus_words, minus_words };
+    }
+
+    double ComputeIdf(const std::string& word) const {
+        size_t document_freq = 0;
+        for (const auto& [document_id, document] : documents_) {
+            document_freq += document.word_freqs.count(word);
+        }
+        return std::log(documents_.size() * 1.0 / document_freq);
+    }
+};
+
+// Текст из слов, которые возвращает generate_word(generator); слов от 1 до max_word_count.
+template <typename WordGenerator>
+std::string GenerateText(std::mt19937& generator, int max_word_count, WordGenerator generate_word) {
+    const int word_count = std::uniform_int_distribution<int>(1, max_word_count)(generator);
+    std::string text;
+    for (int i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text += generate_word(generator);
+    }
+    return text;
+}
+
+// Текст из слов w0 ... w<vocabulary_size - 1>, выбранных равновероятно.
+inline std::string GenerateText(std::mt19937& generator, int max_word_count, int vocabulary_size) {
+    return GenerateText(generator, max_word_count, [vocabulary_size](std::mt19937& word_generator) {
+        return "w" + std::to_string(std::uniform_int_distribution<int>(0, vocabulary_size - 1)(word_generator));
+        });
+}
+
+// Те же документы в том же порядке; релевантность совпадает с точностью epsilon.
+inline void AssertSameDocuments(const std::vector<Document>& documents, const std::vector<Document>& expected, double epsilon = 1e-9) {
+    ASSERT_EQUAL(documents.size(), expected.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        ASSERT_EQUAL(documents[i].id, expected[i].id);
+        ASSERT_NEAR(documents[i].relevance, expected[i].relevance, epsilon);
+        ASSERT_EQUAL(documents[i].rating, expected[i].rating);
+    }
+}
+
+// Результат MatchDocument сервера совпадает с эталонным.
+template <typename StringView>
+void AssertSameMatch(const std::tuple<std::vector<StringView>, DocumentStatus>& match,
+    const std::tuple<std::vector<std::string>, DocumentStatus>& expected) {
+    const auto& [words, status] = match;
+    const auto& [expected_words, expected_status] = expected;
+    ASSERT(std::vector<std::string>(words.begin(), words.end()) == expected_words);
+    ASSERT(status == expected_status);
+}
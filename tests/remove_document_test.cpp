@@ -0,0 +1,109 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+void CheckQueries(const SearchServer& search_server, const ReferenceSearchServer& reference, unsigned seed) {
+    ASSERT_EQUAL(search_server.GetDocumentCount(), reference.GetDocumentCount());
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == reference.GetDocumentIds());
+    mt19937 generator(seed);
+    for (int i = 0; i < 20; ++i) {
+        const string query = GenerateText(generator, 4, 200) + (i % 2 == 0 ? " -w"s + to_string(i + 1) : ""s);
+        const auto expected = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, 10), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, 10), expected);
+    }
+}
+
+// Удаление по одному документу seq и par, с автоматическими очистками списков
+// словопозиций по ходу и явной очисткой в конце: выдача и список идентификаторов
+// совпадают с перебором на каждом шаге.
+void TestRemovalsMatchReference() {
+    mt19937 generator(15);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 20'000; ++id) {
+        const string text = GenerateText(generator, 10, 200);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+
+    vector<int> ids = reference.GetDocumentIds();
+    shuffle(ids.begin(), ids.end(), generator);
+    ids.resize(15'000);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i % 2 == 0) {
+            search_server.RemoveDocument(execution::seq, ids[i]);
+        }
+        else {
+            search_server.RemoveDocument(execution::par, ids[i]);
+        }
+        reference.RemoveDocument(ids[i]);
+        if (i % 1500 == 0) {
+            CheckQueries(search_server, reference, static_cast<unsigned>(i));
+        }
+    }
+    // Повторное удаление и неизвестный идентификатор ничего не меняют.
+    search_server.RemoveDocument(ids[0]);
+    search_server.RemoveDocument(1'000'000);
+    CheckQueries(search_server, reference, 1);
+
+    search_server.PurgeRemovedDocuments(execution::par);
+    CheckQueries(search_server, reference, 2);
+}
+
+// Удалённый идентификатор можно добавить снова с другим текстом, в том числе не
+// по возрастанию идентификаторов.
+void TestReaddRemovedIds() {
+    mt19937 generator(16);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    set<int> live_ids;
+    for (int id = 0; id < 5000; ++id) {
+        const string text = GenerateText(generator, 10, 200);
+        search_server.AddDocument(id * 2, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id * 2, text, DocumentStatus::ACTUAL, id);
+        live_ids.insert(id * 2);
+    }
+    for (int round = 0; round < 3; ++round) {
+        for (int id = round; id < 5000; id += 4) {
+            search_server.RemoveDocument(id * 2);
+            reference.RemoveDocument(id * 2);
+            live_ids.erase(id * 2);
+        }
+        CheckQueries(search_server, reference, 10 + round);
+        for (int id = 4999 - round; id >= 0; id -= 8) {
+            const string text = GenerateText(generator, 10, 200);
+            // Нечётные идентификаторы ещё не встречались, чётные могли быть удалены.
+            for (const int document_id : { id * 2 + 1, id * 2 }) {
+                if (!live_ids.insert(document_id).second) {
+                    continue;
+                }
+                search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, { -document_id });
+                reference.AddDocument(document_id, text, DocumentStatus::ACTUAL, -document_id);
+            }
+        }
+        CheckQueries(search_server, reference, 20 + round);
+        if (round == 1) {
+            search_server.PurgeRemovedDocuments();
+            CheckQueries(search_server, reference, 30);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestRemovalsMatchReference);
+    RUN_TEST(TestReaddRemovedIds);
+}
@@ -0,0 +1,118 @@
+#include "request_queue.h"
+#include "test_framework.h"
+
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+SearchServer MakeSearchServer() {
+    SearchServer search_server("and in at"s);
+    search_server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    search_server.AddDocument(2, "curly dog and fancy collar"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+    search_server.AddDocument(3, "big cat fancy collar "s, DocumentStatus::ACTUAL, { 1, 2, 8 });
+    search_server.AddDocument(4, "big dog sparrow Eugene"s, DocumentStatus::ACTUAL, { 1, 3, 2 });
+    search_server.AddDocument(5, "big dog sparrow Vasiliy"s, DocumentStatus::ACTUAL, { 1, 1, 1 });
+    return search_server;
+}
+
+uint64_t GetHistogramTotal(const RequestStatistics::Statistics& statistics) {
+    return accumulate(statistics.latency_histogram.begin(), statistics.latency_histogram.end(), uint64_t{ 0 });
+}
+
+// Пример из задания: учитываются только последние 1440 запросов.
+void TestNoResultRequestsOfLastDay() {
+    const SearchServer search_server = MakeSearchServer();
+    RequestQueue request_queue(search_server);
+    for (int i = 0; i < 1439; ++i) {
+        request_queue.AddFindRequest("empty request"s);
+    }
+    request_queue.AddFindRequest("curly dog"s);
+    request_queue.AddFindRequest("big collar"s);
+    request_queue.AddFindRequest("sparrow"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1437);
+}
+
+// Запросы из нескольких потоков не теряются ни в кольце последних запросов, ни в статистике.
+void TestRequestsFromManyThreads() {
+    const SearchServer search_server = MakeSearchServer();
+    RequestQueue request_queue(search_server);
+    const int thread_count = 4;
+    const int request_count = 5000;
+
+    vector<thread> threads;
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&request_queue] {
+            for (int j = 0; j < request_count; ++j) {
+                if (j % 2 == 0) {
+                    request_queue.AddFindRequest("curly"s);
+                }
+                else {
+                    request_queue.AddFindRequest("nothing"s, [](int, DocumentStatus, int) {
+                        return true;
+                        });
+                }
+            }
+            });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+
+    const auto statistics = request_queue.GetStatistics();
+    ASSERT_EQUAL(statistics.request_count, uint64_t{ thread_count * request_count });
+    ASSERT_EQUAL(statistics.no_result_count, uint64_t{ thread_count * request_count / 2 });
+    // Запрос с предикатом учитывается без статуса.
+    ASSERT_EQUAL(statistics.status_counts[static_cast<size_t>(DocumentStatus::ACTUAL)], uint64_t{ thread_count * request_count / 2 });
+    ASSERT_EQUAL(GetHistogramTotal(statistics), uint64_t{ thread_count * request_count });
+    ASSERT(request_queue.GetNoResultRequests() >= 0 && request_queue.GetNoResultRequests() <= 1440);
+
+    // Теперь все последние запросы без результата.
+    threads.clear();
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&request_queue] {
+            for (int j = 0; j < 1000; ++j) {
+                request_queue.AddFindRequest("nothing"s);
+            }
+            });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1440);
+}
+
+void TestStatisticsWindow() {
+    RequestStatistics statistics;
+    const auto start = RequestStatistics::Clock::time_point{} + 100h;
+    statistics.AddRequest(start, DocumentStatus::BANNED, false, 3us);
+    statistics.AddRequest(start + 2min, true, 1ms);
+
+    auto result = statistics.GetStatistics(start + 2min, 1min);
+    ASSERT_EQUAL(result.request_count, 1u);
+    result = statistics.GetStatistics(start + 2min, 3min);
+    ASSERT_EQUAL(result.request_count, 2u);
+    ASSERT_EQUAL(result.no_result_count, 1u);
+    ASSERT_EQUAL(result.status_counts[static_cast<size_t>(DocumentStatus::BANNED)], 1u);
+    ASSERT_EQUAL(result.latency_histogram[2], 1u);     // 2-4 мкс
+    ASSERT_EQUAL(result.latency_histogram[10], 1u);    // 512-1024 мкс
+
+    // Через сутки ячейка занята новым интервалом, а запрос за старый отбрасывается.
+    statistics.AddRequest(start + 24h, true, 0us);
+    statistics.AddRequest(start, true, 0us);
+    ASSERT_EQUAL(statistics.GetStatistics(start + 24h, 1min).request_count, 1u);
+    ASSERT_EQUAL(statistics.GetStatistics(start + 24h, 24h).request_count, 2u);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestNoResultRequestsOfLastDay);
+    RUN_TEST(TestRequestsFromManyThreads);
+    RUN_TEST(TestStatisticsWindow);
+}
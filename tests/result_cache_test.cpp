@@ -0,0 +1,132 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+const DocumentStatus STATUSES[] = { DocumentStatus::ACTUAL, DocumentStatus::BANNED };
+
+struct Fixture {
+    SearchServer search_server{ STOP_WORDS };
+    ReferenceSearchServer reference{ STOP_WORDS };
+    vector<string> queries;
+
+    explicit Fixture(unsigned seed) {
+        mt19937 generator(seed);
+        for (int id = 0; id < 2000; ++id) {
+            AddDocument(id, GenerateText(generator, 10, 100), id % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL);
+        }
+        for (int i = 0; i < 30; ++i) {
+            string query = GenerateText(generator, 3, 100);
+            if (i % 3 == 0) {
+                query += " -w"s + to_string(uniform_int_distribution<int>(1, 99)(generator));
+            }
+            queries.push_back(move(query));
+        }
+    }
+
+    void AddDocument(int id, const string& text, DocumentStatus status) {
+        search_server.AddDocument(id, text, status, { id });
+        reference.AddDocument(id, text, status, id);
+    }
+
+    // Выдача по всем запросам и статусам совпадает с перебором.
+    void CheckQueries() const {
+        for (const string& query : queries) {
+            for (const DocumentStatus status : STATUSES) {
+                const auto expected = reference.FindTopDocuments(query, status, SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, status), expected);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status), expected);
+            }
+        }
+    }
+
+    uint64_t GetHits() const {
+        return search_server.GetResultCacheStatistics().hits;
+    }
+};
+
+// Повторный запрос берётся из кэша, а после добавления и удаления документов
+// выдача считается заново.
+void TestCacheInvalidatedByAddAndRemove() {
+    Fixture fixture(17);
+    fixture.search_server.EnableResultCache(1000);
+
+    fixture.CheckQueries();
+    ASSERT(fixture.GetHits() > 0);
+    uint64_t hits = fixture.GetHits();
+    fixture.CheckQueries();
+    // Второй проход целиком из кэша: по два запроса на запрос и статус.
+    ASSERT_EQUAL(fixture.GetHits() - hits, 2 * fixture.queries.size() * size(STATUSES));
+
+    mt19937 generator(170);
+    for (int id = 2000; id < 2100; ++id) {
+        fixture.AddDocument(id, GenerateText(generator, 10, 100), DocumentStatus::ACTUAL);
+    }
+    fixture.CheckQueries();
+
+    for (int id = 0; id < 2000; id += 7) {
+        fixture.search_server.RemoveDocument(id);
+        fixture.reference.RemoveDocument(id);
+    }
+    fixture.CheckQueries();
+}
+
+// Смена статуса меняет выдачу из кэша. Пустое обновление и очистка списков
+// словопозиций выдачу не меняют, и кэш остаётся в силе.
+void TestCacheAfterStatusUpdate() {
+    Fixture fixture(18);
+    fixture.search_server.EnableResultCache(1000);
+    fixture.CheckQueries();
+
+    vector<int> ids;
+    for (int id = 1; id < 2000; id += 5) {
+        ids.push_back(id);
+        fixture.reference.SetStatus(id, DocumentStatus::BANNED);
+    }
+    fixture.search_server.UpdateStatus(ids, DocumentStatus::BANNED);
+    fixture.CheckQueries();
+
+    // Статус уже такой, неизвестные идентификаторы пропускаются.
+    fixture.search_server.UpdateStatus(ids, DocumentStatus::BANNED);
+    fixture.search_server.UpdateStatus({ 100'000, -1 }, DocumentStatus::ACTUAL);
+    uint64_t hits = fixture.GetHits();
+    fixture.CheckQueries();
+    ASSERT_EQUAL(fixture.GetHits() - hits, 2 * fixture.queries.size() * size(STATUSES));
+
+    for (int id = 3; id < 2000; id += 11) {
+        fixture.search_server.RemoveDocument(id);
+        fixture.reference.RemoveDocument(id);
+    }
+    fixture.CheckQueries();
+    fixture.search_server.PurgeRemovedDocuments();
+    hits = fixture.GetHits();
+    fixture.CheckQueries();
+    ASSERT_EQUAL(fixture.GetHits() - hits, 2 * fixture.queries.size() * size(STATUSES));
+}
+
+// Кэш меньше числа запросов вытесняет записи, но выдача остаётся верной.
+void TestSmallCache() {
+    Fixture fixture(19);
+    fixture.search_server.EnableResultCache(4);
+    for (int i = 0; i < 3; ++i) {
+        fixture.CheckQueries();
+    }
+    const auto statistics = fixture.search_server.GetResultCacheStatistics();
+    ASSERT(statistics.misses > fixture.queries.size() * size(STATUSES));
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestCacheInvalidatedByAddAndRemove);
+    RUN_TEST(TestCacheAfterStatusUpdate);
+    RUN_TEST(TestSmallCache);
+}
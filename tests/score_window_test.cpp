@@ -0,0 +1,77 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <atomic>
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+const int VOCABULARY_SIZE = 2000;
+
+// Документов больше, чем помещается в одно окно последовательного поиска, а удалённые
+// документы оставляют в окнах пустые места.
+void TestWindowsMatchReference() {
+    mt19937 generator(3);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 150'000; ++id) {
+        const string text = GenerateText(generator, 6, VOCABULARY_SIZE);
+        const DocumentStatus status = id % 4 == 0 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+        search_server.AddDocument(id, text, status, { id });
+        reference.AddDocument(id, text, status, id);
+    }
+    for (int id = 60'000; id < 80'000; ++id) {
+        search_server.RemoveDocument(id);
+        reference.RemoveDocument(id);
+    }
+
+    for (int i = 0; i < 30; ++i) {
+        string query = GenerateText(generator, 5, VOCABULARY_SIZE);
+        if (i % 2 == 0) {
+            query += " -w"s + to_string(uniform_int_distribution<int>(1, VOCABULARY_SIZE - 1)(generator));
+        }
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT }) {
+            const auto expected = reference.FindTopDocuments(query, status, 5);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, status), expected);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status), expected);
+        }
+        const auto predicate = [](int document_id, DocumentStatus, int) {
+            return document_id % 3 == 0;
+        };
+        const auto expected = reference.FindTopDocuments(query, predicate, 5);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, predicate), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, predicate), expected);
+    }
+}
+
+// Предикат вызывается не больше одного раза на найденный документ, а не на каждую
+// словопозицию.
+void TestPredicateCalledOncePerDocument() {
+    SearchServer search_server(STOP_WORDS);
+    for (int id = 0; id < 1000; ++id) {
+        search_server.AddDocument(id, "w1 w2 w3"s + (id % 2 == 0 ? " w4"s : ""s), DocumentStatus::ACTUAL, { id });
+    }
+    atomic<int> call_count = 0;
+    const auto predicate = [&call_count](int, DocumentStatus, int) {
+        ++call_count;
+        return true;
+    };
+    search_server.FindTopDocuments(execution::seq, "w1 w2 w3 w4"s, predicate);
+    ASSERT(call_count <= 1000);
+    call_count = 0;
+    search_server.FindTopDocuments(execution::par, "w1 w2 w3 w4"s, predicate);
+    ASSERT(call_count <= 1000);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestWindowsMatchReference);
+    RUN_TEST(TestPredicateCalledOncePerDocument);
+}
@@ -0,0 +1,112 @@
+#include "concurrent_search_server.h"
+#include "reference_search_server.h"
+
+#include <algorithm>
+#include <execution>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+const size_t SEGMENT_SIZE = 100;
+
+vector<int> GetSortedIds(const vector<Document>& documents) {
+    vector<int> ids;
+    for (const Document& document : documents) {
+        ids.push_back(document.id);
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Без удалений IDF по всем сегментам совпадает с IDF одного индекса, и выдача
+// совпадает с перебором до и после слияний.
+void TestSegmentsMatchReference() {
+    mt19937 generator(14);
+    ConcurrentSearchServer search_server(STOP_WORDS, SEGMENT_SIZE);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 5000; ++id) {
+        const string text = GenerateText(generator, 10, 300);
+        const DocumentStatus status = id % 6 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(id, text, status, { id });
+        reference.AddDocument(id, text, status, id);
+    }
+
+    const auto check = [&] {
+        ASSERT_EQUAL(search_server.GetDocumentCount(), reference.GetDocumentCount());
+        mt19937 query_generator(140);
+        for (int i = 0; i < 40; ++i) {
+            const string query = GenerateText(query_generator, 4, 300) + " -w"s + to_string(i + 1);
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                const auto expected = reference.FindTopDocuments(query, status, 10);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, status, 10), expected);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status, 10), expected);
+            }
+            const int id = i * 113;
+            AssertSameMatch(search_server.MatchDocument(query, id), reference.MatchDocument(query, id));
+        }
+    };
+    check();
+    search_server.WaitForMerges();
+    ASSERT(search_server.GetSegmentCount() <= ConcurrentSearchServer::MAX_SEALED_SEGMENTS + 1);
+    check();
+}
+
+// Удалённые документы не попадают в выдачу ни до, ни после слияния. Документ
+// запечатанного сегмента нельзя добавить повторно.
+void TestRemovalsAcrossSegments() {
+    mt19937 generator(15);
+    ConcurrentSearchServer search_server(STOP_WORDS, SEGMENT_SIZE);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 3000; ++id) {
+        const string text = GenerateText(generator, 8, 100);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+    // Из первых сегментов удаляется больше половины документов, из остальных - каждый седьмой.
+    for (int id = 0; id < 3000; ++id) {
+        if ((id < 1000 && id % 3 != 0) || id % 7 == 0) {
+            search_server.RemoveDocument(id);
+            reference.RemoveDocument(id);
+        }
+    }
+
+    const auto check = [&] {
+        ASSERT_EQUAL(search_server.GetDocumentCount(), reference.GetDocumentCount());
+        mt19937 query_generator(150);
+        for (int i = 0; i < 40; ++i) {
+            const string query = GenerateText(query_generator, 3, 100);
+            const auto expected = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, 3000);
+            ASSERT(GetSortedIds(search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, 3000)) == GetSortedIds(expected));
+            ASSERT(GetSortedIds(search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, 3000)) == GetSortedIds(expected));
+        }
+    };
+    check();
+    search_server.WaitForMerges();
+    check();
+
+    try {
+        search_server.AddDocument(3, "w1"s, DocumentStatus::ACTUAL, { 1 });
+        ASSERT(false);
+    }
+    catch (const invalid_argument&) {
+    }
+    try {
+        search_server.MatchDocument("w1"s, 1);
+        ASSERT(false);
+    }
+    catch (const out_of_range&) {
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestSegmentsMatchReference);
+    RUN_TEST(TestRemovalsAcrossSegments);
+}
@@ -0,0 +1,83 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+
+#include <cstdio>
+#include <execution>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+// Сервер из снимка отвечает так же, как исходный: удалённые документы в снимок
+// не попадают, статусы, рейтинги и TF сохраняются точно.
+void TestSnapshotRoundTrip(SearchServer::PostingFormat format) {
+    mt19937 generator(9);
+    SearchServer search_server(STOP_WORDS);
+    for (int id = 0; id < 5000; ++id) {
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        // Повторы слов дают разные TF, которые сжатый формат хранит кодами.
+        // Идентификаторы не подряд и не по порядку добавления; разные рейтинги
+        // однозначно упорядочивают документы с равной релевантностью.
+        search_server.AddDocument((id * 7919) % 100'000, GenerateText(generator, 15, 60), status, { id });
+    }
+    // Удаление неизвестного идентификатора ничего не делает.
+    for (int id = 0; id < 100'000; id += 13) {
+        search_server.RemoveDocument(id);
+    }
+
+    const string path = (filesystem::temp_directory_path() / "search_server_snapshot_test.bin").string();
+    search_server.SaveSnapshot(path, format);
+    {
+        const SearchServer snapshot = SearchServer::OpenSnapshot(path);
+        ASSERT(snapshot.IsReadOnly());
+        ASSERT_EQUAL(snapshot.GetDocumentCount(), search_server.GetDocumentCount());
+        ASSERT(vector<int>(snapshot.begin(), snapshot.end()) == vector<int>(search_server.begin(), search_server.end()));
+
+        for (int i = 0; i < 200; ++i) {
+            string query = GenerateText(generator, 4, 60);
+            if (i % 3 == 0) {
+                query += " -w"s + to_string(i % 60);
+            }
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                const auto expected = search_server.FindTopDocuments(execution::seq, query, status, 50);
+                // TF и IDF сохраняются точно, поэтому и релевантность совпадает точно.
+                AssertSameDocuments(snapshot.FindTopDocuments(execution::seq, query, status, 50), expected, 0.0);
+                AssertSameDocuments(snapshot.FindTopDocuments(execution::par, query, status, 50), expected, 0.0);
+            }
+            const int id = *next(search_server.begin(), i * 17 % search_server.GetDocumentCount());
+            ASSERT(snapshot.MatchDocument(query, id) == search_server.MatchDocument(query, id));
+            ASSERT(snapshot.GetWordFrequencies(id) == search_server.GetWordFrequencies(id));
+        }
+
+        SearchServer read_only = SearchServer::OpenSnapshot(path);
+        try {
+            read_only.AddDocument(100'001, "w1"s, DocumentStatus::ACTUAL, { 1 });
+            ASSERT(false);
+        }
+        catch (const logic_error&) {
+        }
+    }
+    remove(path.c_str());
+}
+
+void TestPlainSnapshotRoundTrip() {
+    TestSnapshotRoundTrip(SearchServer::PostingFormat::PLAIN);
+}
+
+void TestCompressedSnapshotRoundTrip() {
+    TestSnapshotRoundTrip(SearchServer::PostingFormat::COMPRESSED);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestPlainSnapshotRoundTrip);
+    RUN_TEST(TestCompressedSnapshotRoundTrip);
+}
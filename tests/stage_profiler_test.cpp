@@ -0,0 +1,111 @@
+#include "search_server.h"
+#include "stage_profiler.h"
+#include "test_framework.h"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+const StageProfiler::StageStatistics& GetStage(const StageProfiler::Statistics& statistics, ProfileStage stage) {
+    return statistics[static_cast<size_t>(stage)];
+}
+
+// Интервалы гистограммы идут подряд, и нижняя граница интервала отстоит от любого
+// его значения не больше чем на 12.5%.
+void TestBuckets() {
+    ASSERT_EQUAL(StageProfiler::GetBucket(0), 0u);
+    ASSERT_EQUAL(StageProfiler::GetBucketLowerBound(0), 0u);
+    for (size_t bucket = 1; bucket < StageProfiler::BUCKET_COUNT; ++bucket) {
+        ASSERT(StageProfiler::GetBucketLowerBound(bucket) > StageProfiler::GetBucketLowerBound(bucket - 1));
+        ASSERT_EQUAL(StageProfiler::GetBucket(StageProfiler::GetBucketLowerBound(bucket)), bucket);
+    }
+
+    mt19937_64 generator(25);
+    for (int i = 0; i < 100'000; ++i) {
+        const uint64_t nanoseconds = generator() >> uniform_int_distribution<int>(4, 63)(generator);
+        const size_t bucket = StageProfiler::GetBucket(nanoseconds);
+        ASSERT(bucket < StageProfiler::BUCKET_COUNT);
+        const uint64_t lower_bound = StageProfiler::GetBucketLowerBound(bucket);
+        ASSERT(lower_bound <= nanoseconds);
+        ASSERT(nanoseconds - lower_bound <= nanoseconds / 8);
+    }
+}
+
+// Замеры всех потоков, в том числе завершившихся, попадают в статистику, а Reset
+// её обнуляет.
+void TestRecordFromThreads() {
+    StageProfiler::Reset();
+    vector<thread> threads;
+    for (int thread_index = 0; thread_index < 4; ++thread_index) {
+        threads.emplace_back([thread_index] {
+            for (int i = 1; i <= 1000; ++i) {
+                StageProfiler::Record(ProfileStage::TOP_K, nanoseconds(i * (thread_index + 1)));
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    StageProfiler::Record(ProfileStage::PARSE, microseconds(3));
+
+    const auto statistics = StageProfiler::GetStatistics();
+    const auto& top_k = GetStage(statistics, ProfileStage::TOP_K);
+    ASSERT_EQUAL(top_k.count, 4000u);
+    ASSERT_EQUAL(top_k.total_nanoseconds, 500'500u * (1 + 2 + 3 + 4));
+    ASSERT_EQUAL(top_k.max_nanoseconds, 4000u);
+    // Точная медиана замеров - 960 нс.
+    const uint64_t median = top_k.GetPercentile(50);
+    ASSERT(median <= 960 && median >= 960 - 960 / 8);
+    ASSERT_EQUAL(GetStage(statistics, ProfileStage::PARSE).count, 1u);
+    ASSERT_EQUAL(GetStage(statistics, ProfileStage::IDF).count, 0u);
+
+    ostringstream out;
+    StageProfiler::Dump(out);
+    ASSERT(out.str().find("top-k: count 4000"s) != string::npos);
+    ASSERT(out.str().find("idf"s) == string::npos);
+
+    StageProfiler::Reset();
+    for (const auto& stage : StageProfiler::GetStatistics()) {
+        ASSERT_EQUAL(stage.count, 0u);
+        ASSERT_EQUAL(stage.GetPercentile(99), 0u);
+    }
+}
+
+// Сервер записывает этапы запроса и изменения индекса, только если замеры
+// включены при сборке.
+void TestSearchServerStages() {
+    StageProfiler::Reset();
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "cat and bird"s, DocumentStatus::ACTUAL, { 2 });
+    search_server.FindTopDocuments("cat -bird"s);
+    search_server.RemoveDocument(2);
+
+    const auto statistics = StageProfiler::GetStatistics();
+    const uint64_t expected_count = StageProfiler::ENABLED ? 1 : 0;
+    ASSERT(GetStage(statistics, ProfileStage::PARSE).count >= expected_count);
+    ASSERT_EQUAL(GetStage(statistics, ProfileStage::ADD_DOCUMENT).count, 2 * expected_count);
+    ASSERT_EQUAL(GetStage(statistics, ProfileStage::REMOVE_DOCUMENT).count, expected_count);
+    if (!StageProfiler::ENABLED) {
+        for (const auto& stage : statistics) {
+            ASSERT_EQUAL(stage.count, 0u);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestBuckets);
+    RUN_TEST(TestRecordFromThreads);
+    RUN_TEST(TestSearchServerStages);
+}
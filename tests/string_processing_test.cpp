@@ -0,0 +1,136 @@
+#include "search_server.h"
+#include "string_processing.h"
+#include "test_framework.h"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Разбор по байту: непустые слова между пробелами.
+vector<string_view> SplitByBytes(string_view text) {
+    vector<string_view> words;
+    size_t begin = 0;
+    for (size_t i = 0; i <= text.size(); ++i) {
+        if (i == text.size() || text[i] == ' ') {
+            if (i > begin) {
+                words.push_back(text.substr(begin, i - begin));
+            }
+            begin = i + 1;
+        }
+    }
+    return words;
+}
+
+// Слово с первым управляющим символом или пустое представление, если их нет.
+string_view FindInvalidWord(string_view text) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (static_cast<unsigned char>(text[i]) < ' ') {
+            size_t begin = text.rfind(' ', i);
+            begin = begin == string_view::npos ? 0 : begin + 1;
+            const size_t end = min(text.find(' ', i), text.size());
+            return text.substr(begin, end - begin);
+        }
+    }
+    return {};
+}
+
+// Слова разной длины, серии пробелов, байты старше 127 и изредка управляющие
+// символы; длины текстов проходят через границы блоков по 16 и 32 байта.
+string GenerateText(mt19937& generator, size_t size, bool with_control) {
+    string text;
+    for (size_t i = 0; i < size; ++i) {
+        const int kind = uniform_int_distribution<int>(0, 99)(generator);
+        if (kind < 25) {
+            text.push_back(' ');
+        }
+        else if (kind < 30) {
+            text.push_back(static_cast<char>(uniform_int_distribution<int>(128, 255)(generator)));
+        }
+        else if (kind < 31 && with_control) {
+            text.push_back(static_cast<char>(uniform_int_distribution<int>(0, 31)(generator)));
+        }
+        else {
+            text.push_back(static_cast<char>(uniform_int_distribution<int>('!', '~')(generator)));
+        }
+    }
+    return text;
+}
+
+void TestSplitMatchesByteLoop() {
+    mt19937 generator(12);
+    for (int i = 0; i < 20'000; ++i) {
+        const size_t size = i < 200 ? i : uniform_int_distribution<size_t>(0, 300)(generator);
+        const string buffer = GenerateText(generator, size + 40, i % 2 == 1);
+        // Текст начинается с разных смещений буфера и не заканчивается нулём.
+        const size_t offset = i % 37;
+        const string_view text(buffer.data() + offset, size);
+        const vector<string_view> expected = SplitByBytes(text);
+        const string_view expected_invalid_word = FindInvalidWord(text);
+
+        if (expected_invalid_word.empty()) {
+            ASSERT(SplitIntoWordsView(text) == expected);
+        }
+        vector<string_view> words;
+        string_view invalid_word;
+        const bool valid = SplitIntoValidWordsView(text, words, invalid_word);
+        ASSERT_EQUAL(valid, expected_invalid_word.empty());
+        if (valid) {
+            ASSERT(words == expected);
+            for (size_t j = 0; j < words.size(); ++j) {
+                ASSERT(words[j].data() == expected[j].data());
+            }
+        }
+        else {
+            ASSERT(invalid_word == expected_invalid_word);
+        }
+    }
+}
+
+void TestEdgeCases() {
+    ASSERT(SplitIntoWordsView(""sv).empty());
+    ASSERT(SplitIntoWordsView("                                        "sv).empty());
+    ASSERT((SplitIntoWordsView("  a  bb   "sv) == vector<string_view>{ "a"sv, "bb"sv }));
+    const string long_word(100, 'x');
+    ASSERT(SplitIntoWordsView(long_word) == vector<string_view>{ long_word });
+}
+
+// Сервер отклоняет документы и запросы с управляющими символами, а пробелы в
+// конце текста не дают пустого слова.
+void TestServerValidation() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat and dog   "s, DocumentStatus::ACTUAL, { 1 });
+    const auto word_freqs = search_server.GetWordFrequencies(1);
+    ASSERT_EQUAL(word_freqs.size(), 2u);
+    ASSERT_NEAR(word_freqs.at("cat"sv), 0.5, 1e-12);
+
+    for (const string& text : { "cat d\x1fg"s, "a\tb"s, "0123456789abcdef0123456789abcdef\x02"s }) {
+        try {
+            search_server.AddDocument(2, text, DocumentStatus::ACTUAL, { 1 });
+            ASSERT(false);
+        }
+        catch (const invalid_argument&) {
+        }
+        try {
+            search_server.FindTopDocuments(text);
+            ASSERT(false);
+        }
+        catch (const invalid_argument&) {
+        }
+    }
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1u);
+    ASSERT_EQUAL(search_server.FindTopDocuments("\xd0\xba\xd0\xbe\xd1\x82 cat"s).size(), 1u);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestSplitMatchesByteLoop);
+    RUN_TEST(TestEdgeCases);
+    RUN_TEST(TestServerValidation);
+}
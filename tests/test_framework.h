@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// Проверки для тестов: при нарушении печатают место и выражение и завершают
+// программу с ненулевым кодом.
+
+#define ASSERT(expr)                                                                        \
+    do {                                                                                    \
+        if (!(expr)) {                                                                      \
+            std::cerr << __FILE__ << '(' << __LINE__ << "): ASSERT(" #expr ") failed" << std::endl; \
+            std::abort();                                                                   \
+        }                                                                                   \
+    } while (false)
+
+#define ASSERT_EQUAL(a, b)                                                                  \
+    do {                                                                                    \
+        if (!((a) == (b))) {                                                                \
+            std::cerr << __FILE__ << '(' << __LINE__ << "): ASSERT_EQUAL(" #a ", " #b ") failed: " \
+                << (a) << " != " << (b) << std::endl;                                       \
+            std::abort();                                                                   \
+        }                                                                                   \
+    } while (false)
+
+#define ASSERT_NEAR(a, b, epsilon)                                                          \
+    do {                                                                                    \
+        if (!(std::abs((a) - (b)) <= (epsilon))) {                                          \
+            std::cerr << __FILE__ << '(' << __LINE__ << "): ASSERT_NEAR(" #a ", " #b ") failed: " \
+                << (a) << " != " << (b) << std::endl;                                       \
+            std::abort();                                                                   \
+        }                                                                                   \
+    } while (false)
+
+#define RUN_TEST(func)                                   \
+    do {                                                 \
+        func();                                          \
+        std::cerr << #func << " OK" << std::endl;        \
+    } while (false)
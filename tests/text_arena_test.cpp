@@ -0,0 +1,88 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+#include "text_arena.h"
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Выданные тексты не перемещаются при добавлении следующих, в том числе текстов
+// длиннее страницы.
+void TestTextArenaKeepsTexts() {
+    mt19937 generator(8);
+    TextArena arena;
+    vector<string> texts;
+    vector<TextArena::TextRef> refs;
+    vector<const char*> addresses;
+    size_t total_size = 0;
+    for (int i = 0; i < 3000; ++i) {
+        const size_t size = i % 500 == 0 ? TextArena::PAGE_SIZE + i : uniform_int_distribution<size_t>(0, 2000)(generator);
+        string text(size, 'a' + i % 26);
+        // Текст передаётся без завершающего нуля: за ним в буфере идут другие байты.
+        const string buffer = text + "tail"s;
+        refs.push_back(arena.Append(string_view(buffer.data(), size)));
+        addresses.push_back(arena.Get(refs.back()).data());
+        texts.push_back(move(text));
+        total_size += size;
+    }
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const string_view text = arena.Get(refs[i]);
+        ASSERT(text == texts[i]);
+        ASSERT(text.data() == addresses[i]);
+    }
+    ASSERT(arena.GetAllocatedBytes() >= total_size);
+}
+
+// Слова документа и стоп-слова берутся по длине string_view, а не до нулевого байта.
+void TestViewsWithoutTerminator() {
+    const string stop_words = "w1 w2 w3"s;
+    SearchServer search_server(string_view(stop_words.data(), 5));
+    const string text = "w1 w3 w4 w5"s;
+    search_server.AddDocument(1, string_view(text.data(), 8), DocumentStatus::ACTUAL, { 1 });
+
+    const auto word_freqs = search_server.GetWordFrequencies(1);
+    ASSERT_EQUAL(word_freqs.size(), 2u);
+    ASSERT_EQUAL(word_freqs.count("w3"sv), 1u);
+    ASSERT_EQUAL(word_freqs.count("w4"sv), 1u);
+    ASSERT(search_server.FindTopDocuments("w5"s).empty());
+    ASSERT(search_server.FindTopDocuments("w1"s).empty());
+
+    const vector<string_view> stop_word_views = { string_view(stop_words.data(), 2), string_view(stop_words.data() + 3, 2) };
+    SearchServer view_server(stop_word_views);
+    view_server.AddDocument(1, "w1 w2 w3"s, DocumentStatus::ACTUAL, { 1 });
+    const auto view_word_freqs = view_server.GetWordFrequencies(1);
+    ASSERT_EQUAL(view_word_freqs.size(), 1u);
+    ASSERT_EQUAL(view_word_freqs.count("w3"sv), 1u);
+}
+
+// Тексты документов в арене переживают исходные строки.
+void TestSearchAfterSourceStringsAreGone() {
+    mt19937 generator(80);
+    SearchServer search_server("w0"s);
+    ReferenceSearchServer reference("w0"s);
+    for (int id = 0; id < 5000; ++id) {
+        string text = GenerateText(generator, 10, 500);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+        fill(text.begin(), text.end(), 'x');
+    }
+    for (int i = 0; i < 50; ++i) {
+        const string query = GenerateText(generator, 4, 500);
+        const auto expected = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+        AssertSameDocuments(search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10), expected);
+        AssertSameMatch(search_server.MatchDocument(query, i * 100), reference.MatchDocument(query, i * 100));
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestTextArenaKeepsTexts);
+    RUN_TEST(TestViewsWithoutTerminator);
+    RUN_TEST(TestSearchAfterSourceStringsAreGone);
+}
@@ -0,0 +1,94 @@
+#include "reference_search_server.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+#include <algorithm>
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "w0"s;
+
+// Релевантности повторяются, чтобы порядок решал рейтинг.
+vector<Document> GenerateDocuments(mt19937& generator, int document_count) {
+    vector<Document> documents;
+    for (int id = 0; id < document_count; ++id) {
+        const double relevance = uniform_int_distribution<int>(0, 50)(generator) * 0.01;
+        documents.push_back({ id, relevance, id * 7 % document_count });
+    }
+    return documents;
+}
+
+vector<Document> SortAndTruncate(vector<Document> documents, size_t count) {
+    stable_sort(documents.begin(), documents.end(), IsMoreRelevant);
+    documents.resize(min(documents.size(), count));
+    return documents;
+}
+
+// Куча отбирает те же K документов в том же порядке, что и полная сортировка.
+void TestTopDocumentsMatchesSort() {
+    mt19937 generator(4);
+    for (const size_t capacity : { 0u, 1u, 5u, 64u, 1000u, 5000u }) {
+        const vector<Document> documents = GenerateDocuments(generator, 1000);
+        TopDocuments top_documents(capacity);
+        for (const Document& document : documents) {
+            top_documents.Push(document);
+        }
+        ASSERT_EQUAL(top_documents.IsFull(), capacity <= documents.size());
+        const auto expected = SortAndTruncate(documents, capacity);
+        if (!expected.empty()) {
+            ASSERT_EQUAL(top_documents.GetWorst().id, expected.back().id);
+        }
+        AssertSameDocuments(top_documents.Extract(), expected);
+    }
+}
+
+// Слияние куч по частям документов даёт то же, что одна куча по всем.
+void TestMerge() {
+    mt19937 generator(40);
+    const vector<Document> documents = GenerateDocuments(generator, 3000);
+    TopDocuments merged(10);
+    for (size_t begin = 0; begin < documents.size(); begin += 700) {
+        TopDocuments part(10);
+        for (size_t i = begin; i < min(begin + 700, documents.size()); ++i) {
+            part.Push(documents[i]);
+        }
+        merged.Merge(part);
+    }
+    AssertSameDocuments(merged.Extract(), SortAndTruncate(documents, 10));
+}
+
+// Выдача сервера любого размера совпадает с перебором.
+void TestResultCount() {
+    mt19937 generator(41);
+    SearchServer search_server(STOP_WORDS);
+    ReferenceSearchServer reference(STOP_WORDS);
+    for (int id = 0; id < 5000; ++id) {
+        const string text = GenerateText(generator, 8, 300);
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        reference.AddDocument(id, text, DocumentStatus::ACTUAL, id);
+    }
+    for (int i = 0; i < 30; ++i) {
+        const string query = GenerateText(generator, 3, 300);
+        for (const size_t result_count : { 0u, 1u, 5u, 100u, 10'000u }) {
+            const auto expected = reference.FindTopDocuments(query, DocumentStatus::ACTUAL, result_count);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, result_count), expected);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, result_count), expected);
+        }
+        AssertSameDocuments(search_server.FindTopDocuments(query),
+            reference.FindTopDocuments(query, DocumentStatus::ACTUAL, SearchServer::DEFAULT_RESULT_DOCUMENT_COUNT));
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestTopDocumentsMatchesSort);
+    RUN_TEST(TestMerge);
+    RUN_TEST(TestResultCount);
+}
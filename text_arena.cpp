@@ -0,0 +1,47 @@
+#include <algorithm>
+
+#include "text_arena.h"
+
+TextArena::TextRef TextArena::Append(std::string_view text) {
+    const uint32_t size = static_cast<uint32_t>(text.size());
+    if (size == 0) {
+        return {};
+    }
+
+    if (size > PAGE_SIZE) {
+        char* page = AllocatePage(size);
+        std::copy(text.begin(), text.end(), page);
+        const uint32_t page_index = static_cast<uint32_t>(pages_.size() - 1);
+        // Следующий текст не должен попасть в страницу под длинный текст.
+        page_used_ = PAGE_SIZE;
+        return { page_index, 0, size };
+    }
+
+    if (PAGE_SIZE - page_used_ < size) {
+        AllocatePage(PAGE_SIZE);
+        page_used_ = 0;
+    }
+
+    const uint32_t page_index = static_cast<uint32_t>(pages_.size() - 1);
+    std::copy(text.begin(), text.end(), pages_.back().get() + page_used_);
+    const TextRef ref{ page_index, page_used_, size };
+    page_used_ += size;
+    return ref;
+}
+
+std::string_view TextArena::Get(TextRef ref) const {
+    if (ref.size == 0) {
+        return {};
+    }
+    return { pages_[ref.page].get() + ref.offset, ref.size };
+}
+
+size_t TextArena::GetAllocatedBytes() const {
+    return allocated_bytes_;
+}
+
+char* TextArena::AllocatePage(size_t size) {
+    pages_.emplace_back(new char[size]);
+    allocated_bytes_ += size;
+    return pages_.back().get();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+	* Хранилище текстов индекса. Байты дописываются в страницы фиксированного
+	* размера, страницы никогда не перемещаются и не освобождаются, поэтому
+	* выданные ссылки и string_view остаются валидными всё время жизни арены.
+	**/
+class TextArena {
+public:
+    static constexpr uint32_t PAGE_SIZE = 1 << 20;
+
+    // Положение текста в арене. Тексты длиннее страницы занимают отдельную страницу.
+    struct TextRef {
+        uint32_t page = 0;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    TextRef Append(std::string_view text);
+
+    std::string_view Get(TextRef ref) const;
+
+    size_t GetAllocatedBytes() const;
+
+private:
+    std::vector<std::unique_ptr<char[]>> pages_;
+    uint32_t page_used_ = PAGE_SIZE;
+    size_t allocated_bytes_ = 0;
+
+    char* AllocatePage(size_t size);
+};
@@ -0,0 +1,43 @@
+#include <cmath>
+#include <limits>
+
+#include "top_documents.h"
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < SMALL_RANGE_FOR_COMPARE) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+TopDocuments::TopDocuments(size_t capacity)
+    : capacity_(capacity)
+{
+    heap_.reserve(std::min<size_t>(capacity, 1024));
+}
+
+void TopDocuments::Merge(const TopDocuments& other) {
+    for (const Document& document : other.heap_) {
+        Push(document);
+    }
+}
+
+bool TopDocuments::IsFull() const {
+    return heap_.size() == capacity_;
+}
+
+const Document& TopDocuments::GetWorst() const {
+    return heap_.front();
+}
+
+double TopDocuments::GetRelevanceThreshold() const {
+    if (!IsFull() || heap_.empty()) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return heap_.front().relevance - SMALL_RANGE_FOR_COMPARE;
+}
+
+std::vector<Document> TopDocuments::Extract() {
+    std::sort_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    return std::move(heap_);
+}
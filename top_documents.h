@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "document.h"
+
+#define SMALL_RANGE_FOR_COMPARE 1e-6 // для сравнения вещественных чисел.
+
+// Порядок выдачи: по убыванию релевантности, при равной релевантности - по убыванию рейтинга.
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+/**
+	* Отбор K лучших документов без сортировки всех найденных.
+	* Документы хранятся в куче, на вершине которой худший из отобранных.
+	**/
+class TopDocuments {
+public:
+    explicit TopDocuments(size_t capacity);
+
+    void Push(const Document& document) {
+        if (heap_.size() < capacity_) {
+            heap_.push_back(document);
+            std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        }
+        else if (capacity_ > 0 && IsMoreRelevant(document, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+            heap_.back() = document;
+            std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        }
+    }
+
+    void Merge(const TopDocuments& other);
+
+    bool IsFull() const;
+
+    // Худший из отобранных документов. Только для непустого набора.
+    const Document& GetWorst() const;
+
+    // Документ с релевантностью ниже порога уже не может попасть в заполненный набор.
+    // Пока набор не заполнен, порог равен минус бесконечности.
+    double GetRelevanceThreshold() const;
+
+    // Отобранные документы в порядке выдачи.
+    std::vector<Document> Extract();
+
+private:
+    size_t capacity_;
+    std::vector<Document> heap_;
+};
@@ -0,0 +1,114 @@
+#include "work_stealing_pool.h"
+
+namespace {
+
+// Пул и очередь, за которыми закреплён текущий поток.
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t thread_count)
+    : queues_(std::max<size_t>(thread_count, 1))
+{
+    threads_.reserve(queues_.size());
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        threads_.emplace_back([this, i] {
+            WorkerLoop(i);
+            });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t WorkStealingPool::GetThreadCount() const {
+    return threads_.size();
+}
+
+void WorkStealingPool::Submit(std::function<void()> task) {
+    size_t queue = GetOwnQueue();
+    if (queue == queues_.size()) {
+        queue = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+    // Счётчик растёт раньше, чем задачу можно взять, и не уходит в минус.
+    queued_task_count_.fetch_add(1);
+    {
+        std::lock_guard lock(queues_[queue].mutex);
+        queues_[queue].tasks.push_back(std::move(task));
+    }
+
+    // Захват мьютекса не даёт уснуть потоку, который уже проверил, что задач нет.
+    {
+        std::lock_guard lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+}
+
+WorkStealingPool::ExecutionPolicy WorkStealingPool::GetExecutionPolicy() {
+    return ExecutionPolicy{ *this };
+}
+
+void WorkStealingPool::Notify() {
+    {
+        std::lock_guard lock(sleep_mutex_);
+    }
+    wake_.notify_all();
+}
+
+size_t WorkStealingPool::GetOwnQueue() const {
+    return current_pool == this ? current_queue : queues_.size();
+}
+
+bool WorkStealingPool::RunTask(size_t own_queue) {
+    std::function<void()> task;
+    if (own_queue < queues_.size()) {
+        TaskQueue& queue = queues_[own_queue];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+    for (size_t i = 1; !task && i <= queues_.size(); ++i) {
+        TaskQueue& queue = queues_[(own_queue + i) % queues_.size()];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+
+    queued_task_count_.fetch_sub(1);
+    task();
+    return true;
+}
+
+void WorkStealingPool::WorkerLoop(size_t index) {
+    current_pool = this;
+    current_queue = index;
+
+    while (true) {
+        if (RunTask(index)) {
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        wake_.wait(lock, [this] {
+            return stopping_ || queued_task_count_.load() > 0;
+            });
+        if (stopping_ && queued_task_count_.load() == 0) {
+            return;
+        }
+    }
+}
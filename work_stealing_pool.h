@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+	* Пул потоков с перехватом работы. У каждого потока своя очередь: новые задачи
+	* поток кладёт в её конец и сам берёт оттуда же, поэтому дочерние задачи
+	* выполняются сразу после родительской, пока данные ещё в кэше. Простаивающий
+	* поток забирает задачу из начала чужой очереди - там самые старые и обычно
+	* самые крупные задачи. Задачи не должны выпускать исключения.
+	**/
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t GetThreadCount() const;
+
+    // Из потока пула задача попадает в его очередь, из другого потока - в очереди по кругу.
+    void Submit(std::function<void()> task);
+
+    // Вызывает function для каждого элемента [first, last) задачами пула и ждёт их,
+    // выполняя задачи сам, поэтому вызывать можно и из задачи пула. Итераторы
+    // произвольного доступа; function не должна выпускать исключения.
+    template <typename Iterator, typename Function>
+    void ForEach(Iterator first, Iterator last, Function function);
+
+    // Политика выполнения для SearchServer::FindTopDocuments: окна документов
+    // запроса считаются задачами этого пула, а не потоками стандартной библиотеки.
+    struct ExecutionPolicy {
+        WorkStealingPool& pool;
+    };
+
+    ExecutionPolicy GetExecutionPolicy();
+
+    // Выполняет задачи пула в вызывающем потоке, пока done() ложно, поэтому ждать
+    // можно и из задачи пула. Задача, после которой done() становится истинным,
+    // должна вызвать Notify.
+    template <typename Predicate>
+    void Wait(Predicate done);
+
+    // Будит потоки, ждущие в Wait.
+    void Notify();
+
+private:
+    struct alignas(64) TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<TaskQueue> queues_;    // по очереди на поток, размер не меняется
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_queue_{ 0 };
+    std::atomic<size_t> queued_task_count_{ 0 };
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    // Номер очереди потока пула; для другого потока - queues_.size().
+    size_t GetOwnQueue() const;
+
+    // Выполняет задачу из своей очереди или из чужой; false, если задач нет.
+    bool RunTask(size_t own_queue);
+
+    // Вторая половина диапазона уходит в очередь, первая обрабатывается сразу:
+    // в очередях остаётся логарифм от размера диапазона задач.
+    template <typename Iterator, typename Function>
+    void ForEachRange(Iterator first, Iterator last, Function& function, std::atomic<size_t>& running_task_count);
+
+    void WorkerLoop(size_t index);
+};
+
+template <typename Iterator, typename Function>
+void WorkStealingPool::ForEach(Iterator first, Iterator last, Function function) {
+    if (first == last) {
+        return;
+    }
+    std::atomic<size_t> running_task_count{ 1 };
+    ForEachRange(first, last, function, running_task_count);
+    Wait([&running_task_count] {
+        return running_task_count.load() == 0;
+        });
+}
+
+template <typename Iterator, typename Function>
+void WorkStealingPool::ForEachRange(Iterator first, Iterator last, Function& function, std::atomic<size_t>& running_task_count) {
+    while (last - first > 1) {
+        const Iterator middle = first + (last - first) / 2;
+        running_task_count.fetch_add(1);
+        Submit([this, middle, last, &function, &running_task_count] {
+            ForEachRange(middle, last, function, running_task_count);
+            });
+        last = middle;
+    }
+    function(*first);
+
+    if (running_task_count.fetch_sub(1) == 1) {
+        Notify();
+    }
+}
+
+template <typename Predicate>
+void WorkStealingPool::Wait(Predicate done) {
+    const size_t own_queue = GetOwnQueue();
+    while (!done()) {
+        if (RunTask(own_queue)) {
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        wake_.wait(lock, [&] {
+            return done() || queued_task_count_.load() > 0;
+            });
+    }
+}